@@ -0,0 +1,177 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include <string.h>
+
+#include "CfarDetector.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define CFAR_SSE2
+#include <emmintrin.h>
+#endif
+
+void CfarPrefixSums(const uint8_t *data, size_t len, uint32_t *sums) {
+  uint32_t sum = 0;
+  size_t r = 0;
+
+  sums[0] = 0;
+#ifdef CFAR_SSE2
+  // 16 returns at a time: a scan of the 16 bit lanes of each half (at most 8 * 255),
+  // then widened to 32 bits with the sum so far added.
+  const __m128i zero = _mm_setzero_si128();
+  __m128i carry = zero;
+  for (; r + 16 <= len; r += 16) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(data + r));
+    __m128i lo = _mm_unpacklo_epi8(x, zero);
+    __m128i hi = _mm_unpackhi_epi8(x, zero);
+    lo = _mm_add_epi16(lo, _mm_slli_si128(lo, 2));
+    hi = _mm_add_epi16(hi, _mm_slli_si128(hi, 2));
+    lo = _mm_add_epi16(lo, _mm_slli_si128(lo, 4));
+    hi = _mm_add_epi16(hi, _mm_slli_si128(hi, 4));
+    lo = _mm_add_epi16(lo, _mm_slli_si128(lo, 8));
+    hi = _mm_add_epi16(hi, _mm_slli_si128(hi, 8));
+
+    __m128i s0 = _mm_add_epi32(_mm_unpacklo_epi16(lo, zero), carry);
+    __m128i s1 = _mm_add_epi32(_mm_unpackhi_epi16(lo, zero), carry);
+    carry = _mm_shuffle_epi32(s1, 0xff);
+    __m128i s2 = _mm_add_epi32(_mm_unpacklo_epi16(hi, zero), carry);
+    __m128i s3 = _mm_add_epi32(_mm_unpackhi_epi16(hi, zero), carry);
+    carry = _mm_shuffle_epi32(s3, 0xff);
+
+    _mm_storeu_si128((__m128i *)(sums + r + 1), s0);
+    _mm_storeu_si128((__m128i *)(sums + r + 5), s1);
+    _mm_storeu_si128((__m128i *)(sums + r + 9), s2);
+    _mm_storeu_si128((__m128i *)(sums + r + 13), s3);
+  }
+  sum = (uint32_t)_mm_cvtsi128_si32(carry);
+#endif
+  for (; r < len; r++) {
+    sum += data[r];
+    sums[r + 1] = sum;
+  }
+}
+
+static inline void SetBits(HistoryWord *detect, size_t r, HistoryWord bits) {
+  size_t shift = r % HISTORY_WORD_BITS;
+
+  detect[r / HISTORY_WORD_BITS] |= bits << shift;
+  if (shift > 0) {
+    bits >>= HISTORY_WORD_BITS - shift;
+    if (bits) {
+      detect[r / HISTORY_WORD_BITS + 1] |= bits;
+    }
+  }
+}
+
+// The sums of the training cells of return r and how many there are, for the ends of the spoke
+static inline uint32_t EdgeNoise(const uint32_t *sums, size_t len, size_t r, const CfarWindow &window, unsigned *cells) {
+  size_t lead_end = r >= window.guard ? r - window.guard : 0;
+  size_t lead_start = r >= window.guard + window.train ? r - window.guard - window.train : 0;
+  size_t lag_start = r + window.guard + 1 < len ? r + window.guard + 1 : len;
+  size_t lag_end = r + window.guard + window.train + 1 < len ? r + window.guard + window.train + 1 : len;
+
+  *cells = (unsigned)(lead_end - lead_start + lag_end - lag_start);
+  return sums[lead_end] - sums[lead_start] + sums[lag_end] - sums[lag_start];
+}
+
+static void DetectEdge(const uint8_t *data, size_t len, const uint32_t *sums, const uint32_t *previous, const CfarWindow &window,
+                       size_t first, size_t end, HistoryWord *detect) {
+  for (size_t r = first; r < end; r++) {
+    unsigned cells;
+    uint32_t noise = EdgeNoise(sums, len, r, window, &cells);
+
+    if (previous) {
+      noise += EdgeNoise(previous, len, r, window, &cells);
+      cells *= 2;
+    }
+    if (cells > 0 && (float)data[r] > window.scale / (float)cells * (float)noise) {
+      SetBits(detect, r, 1);
+    }
+  }
+}
+
+void CfarDetect(const uint8_t *data, size_t len, const uint32_t *sums, const uint32_t *previous, const CfarWindow &window,
+                HistoryWord *detect) {
+  const size_t guard = window.guard;
+  const size_t reach = window.guard + window.train;
+
+  memset(detect, 0, HISTORY_WORDS(len) * sizeof(HistoryWord));
+  if (len <= 2 * reach) {
+    DetectEdge(data, len, sums, previous, window, 0, len, detect);
+    return;
+  }
+
+  // Returns [reach, len - reach) have all their training cells
+  size_t end = len - reach;
+  const float factor = window.scale / (float)(window.train * (previous ? 4 : 2));
+  size_t r = reach;
+
+  DetectEdge(data, len, sums, previous, window, 0, reach, detect);
+
+#ifdef CFAR_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 f = _mm_set1_ps(factor);
+  for (; r + 4 <= end; r += 4) {
+    __m128i lead = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(sums + r - guard)),
+                                 _mm_loadu_si128((const __m128i *)(sums + r - reach)));
+    __m128i lag = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(sums + r + reach + 1)),
+                                _mm_loadu_si128((const __m128i *)(sums + r + guard + 1)));
+    __m128i noise = _mm_add_epi32(lead, lag);
+    if (previous) {
+      lead = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(previous + r - guard)),
+                           _mm_loadu_si128((const __m128i *)(previous + r - reach)));
+      lag = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(previous + r + reach + 1)),
+                          _mm_loadu_si128((const __m128i *)(previous + r + guard + 1)));
+      noise = _mm_add_epi32(noise, _mm_add_epi32(lead, lag));
+    }
+
+    int32_t four;
+    memcpy(&four, data + r, sizeof(four));
+    __m128i d = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(four), zero), zero);
+    __m128 target = _mm_cmpgt_ps(_mm_cvtepi32_ps(d), _mm_mul_ps(f, _mm_cvtepi32_ps(noise)));
+    int bits = _mm_movemask_ps(target);
+    if (bits) {
+      SetBits(detect, r, (HistoryWord)bits);
+    }
+  }
+#endif
+  for (; r < end; r++) {
+    uint32_t noise = sums[r - guard] - sums[r - reach] + sums[r + reach + 1] - sums[r + guard + 1];
+    if (previous) {
+      noise += previous[r - guard] - previous[r - reach] + previous[r + reach + 1] - previous[r + guard + 1];
+    }
+    if ((float)data[r] > factor * (float)noise) {
+      SetBits(detect, r, 1);
+    }
+  }
+
+  DetectEdge(data, len, sums, previous, window, end, len, detect);
+}
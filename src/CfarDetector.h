@@ -0,0 +1,70 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _CFAR_DETECTOR_H_
+#define _CFAR_DETECTOR_H_
+
+#include "SweepHistory.h"
+
+/*
+ * Cell averaging constant false alarm rate (CA-CFAR) detection along a spoke. The noise
+ * around a return is estimated from the training cells on either side of it, leaving
+ * out the guard cells right next to it, and the return is a target when it is more than
+ * 'scale' times that average. The window sums come from a prefix sum of the spoke, so
+ * the cost does not depend on the window size. Near the ends of the spoke the windows
+ * are cut off and the average is over the cells that are left.
+ *
+ * The training cells of the previous spoke can be added as well, which averages the
+ * noise over two azimuths.
+ */
+
+#define CFAR_TRAINING_MAX (64)  // Most training cells on each side
+#define CFAR_GUARD_MAX (16)     // Most guard cells on each side
+
+#define DEFAULT_CFAR_TRAINING (16)
+#define DEFAULT_CFAR_GUARD (2)
+#define DEFAULT_CFAR_SCALE (3.0)
+
+struct CfarWindow {
+  unsigned guard;  // Cells on each side of the cell under test that are not training cells
+  unsigned train;  // Training cells on each side, 1..CFAR_TRAINING_MAX
+  float scale;     // Times the noise average that a target has to be
+};
+
+// sums[r] = data[0] + ... + data[r - 1] for r <= len, so sums has room for len + 1.
+extern void CfarPrefixSums(const uint8_t *data, size_t len, uint32_t *sums);
+
+// Set bit r of detect[] when data[r] is a target, for r < len. Bits beyond len are cleared.
+// previous holds the prefix sums of the previous spoke, of the same len, or is null.
+extern void CfarDetect(const uint8_t *data, size_t len, const uint32_t *sums, const uint32_t *previous,
+                       const CfarWindow &window, HistoryWord *detect);
+
+#endif /* _CFAR_DETECTOR_H_ */
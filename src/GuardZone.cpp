@@ -34,74 +34,209 @@ PLUGIN_BEGIN_NAMESPACE
 
 #undef TEST_GUARD_ZONE_LOCATION
 
-void GuardZone::ProcessSpoke(SpokeBearing angle, UINT8* data, UINT8* hist, size_t len, int range) {
-  size_t range_start = m_inner_range * RETURNS_PER_LINE / range;  // Convert from meters to 0..511
-  size_t range_end = m_outer_range * RETURNS_PER_LINE / range;    // Convert from meters to 0..511
-  bool in_guard_zone = false;
-
-  switch (m_type) {
-    case GZ_ARC:
-      if ((angle >= m_start_bearing && angle < m_end_bearing) ||
-          (m_start_bearing >= m_end_bearing && (angle >= m_start_bearing || angle < m_end_bearing))) {
-        if (range_start < RETURNS_PER_LINE) {
-          if (range_end > RETURNS_PER_LINE) {
-            range_end = RETURNS_PER_LINE;
-          }
-
-          for (size_t r = range_start; r <= range_end; r++) {
-            if (!m_multi_sweep_filter || HISTORY_FILTER_ALLOW(hist[r])) {
-              if (data[r] >= m_pi->m_settings.threshold_blue) {
-                m_running_count++;
-              }
 #ifdef TEST_GUARD_ZONE_LOCATION
-              // Zap guard zone computation location to green so this is visible on screen
-              else {
-                data[r] = m_pi->m_settings.threshold_green;
-              }
+// Zap guard zone computation location to green so this is visible on screen
+static void MarkLocation(UINT8* data, const HistoryWord* strong, const HistoryWord* filter, size_t first, size_t last,
+                         UINT8 colour) {
+  for (size_t r = first; r <= last; r++) {
+    HistoryWord bit = (HistoryWord)1 << (r % HISTORY_WORD_BITS);
+    if ((!filter || (filter[r / HISTORY_WORD_BITS] & bit)) && !(strong[r / HISTORY_WORD_BITS] & bit)) {
+      data[r] = colour;
+    }
+  }
+}
 #endif
-            }
-          }
-        }
-        in_guard_zone = true;
+
+bool GuardZone::SetPolygon(const wxString& corners) {
+  GuardZoneCorner polygon[GUARD_ZONE_CORNERS_MAX];
+  size_t count = 0;
+  wxString rest = corners;
+
+  while (!rest.IsEmpty()) {
+    wxString corner = rest.BeforeFirst(wxT(';'));
+    rest = rest.AfterFirst(wxT(';'));
+    double bearing;
+    long range;
+    if (count == GUARD_ZONE_CORNERS_MAX || !corner.BeforeFirst(wxT(',')).ToDouble(&bearing) ||
+        !corner.AfterFirst(wxT(',')).ToLong(&range) || range < 0) {
+      wxLogError(wxT("%s invalid polygon '%s'"), m_log_name.c_str(), corners.c_str());
+      return false;
+    }
+    polygon[count].bearing = bearing;
+    polygon[count].range = (int)range;
+    count++;
+  }
+  if (count > 0 && count < 3) {
+    wxLogError(wxT("%s invalid polygon '%s'"), m_log_name.c_str(), corners.c_str());
+    return false;
+  }
+
+  memcpy(m_polygon, polygon, sizeof(polygon));
+  m_polygon_corners = count;
+  m_polygon_version++;
+  ResetBogeys();
+  return true;
+}
+
+wxString GuardZone::GetPolygon() {
+  wxString s;
+
+  for (size_t c = 0; c < m_polygon_corners; c++) {
+    if (c > 0) {
+      s << wxT(";");
+    }
+    s << wxString::Format(wxT("%g,%d"), m_polygon[c].bearing, m_polygon[c].range);
+  }
+  return s;
+}
+
+// Outline of a polygon zone, in the units and rotation of DrawOutlineArc
+void GuardZone::RenderPolygon() {
+  glBegin(GL_LINE_LOOP);
+  for (size_t c = 0; c < m_polygon_corners; c++) {
+    double a = deg2rad(m_polygon[c].bearing);
+    glVertex2f(m_polygon[c].range * cos(a), m_polygon[c].range * sin(a));
+  }
+  glEnd();
+}
+
+bool GuardZone::IsCompiled(int range, size_t len) {
+  return m_compiled.type == m_type && m_compiled.start_bearing == m_start_bearing && m_compiled.end_bearing == m_end_bearing &&
+         m_compiled.inner_range == m_inner_range && m_compiled.outer_range == m_outer_range &&
+         m_compiled.polygon_version == m_polygon_version && m_compiled.range == range && m_compiled.len == len;
+}
+
+void GuardZone::Compile(int range, size_t len) {
+  size_t range_start = m_inner_range * len / range;  // Convert from meters to 0..len-1
+  size_t range_end = m_outer_range * len / range;    // Convert from meters to 0..len-1
+  if (range_end >= len) {
+    range_end = len - 1;
+  }
+
+  for (SpokeBearing angle = 0; angle < LINES_PER_ROTATION; angle++) {
+    bool in_arc = true;
+    if (m_type == GZ_ARC) {
+      in_arc = (angle >= m_start_bearing && angle < m_end_bearing) ||
+               (m_start_bearing >= m_end_bearing && (angle >= m_start_bearing || angle < m_end_bearing));
+    }
+    if ((m_type == GZ_ARC || m_type == GZ_CIRCLE) && in_arc && range_start < len) {
+      m_first[angle] = (UINT16)range_start;
+      m_last[angle] = (UINT16)range_end;
+    } else {
+      m_first[angle] = 1;
+      m_last[angle] = 0;
+    }
+    switch (m_type) {
+      case GZ_ARC:
+        m_sweeps[angle] = in_arc;
+        break;
+      case GZ_CIRCLE:
+        m_sweeps[angle] = range_start < len;
+        break;
+      default:
+        m_sweeps[angle] = m_type != GZ_OFF;
+        break;
+    }
+  }
+
+  if (m_type == GZ_POLYGON) {
+    CompilePolygon(range, len);
+  }
+
+  m_compiled.type = m_type;
+  m_compiled.start_bearing = m_start_bearing;
+  m_compiled.end_bearing = m_end_bearing;
+  m_compiled.inner_range = m_inner_range;
+  m_compiled.outer_range = m_outer_range;
+  m_compiled.polygon_version = m_polygon_version;
+  m_compiled.range = range;
+  m_compiled.len = len;
+  LOG_VERBOSE(wxT("%s compiled for range %d, %u returns"), m_log_name.c_str(), range, (unsigned)len);
+}
+
+/*
+ * Sets the bit of every return whose middle lies inside the polygon. Each line is a ray
+ * from the boat; where it crosses the edges it goes in or out of the polygon.
+ */
+void GuardZone::CompilePolygon(int range, size_t len) {
+  double x[GUARD_ZONE_CORNERS_MAX];
+  double y[GUARD_ZONE_CORNERS_MAX];
+  double crossing[GUARD_ZONE_CORNERS_MAX + 1];
+
+  if (!m_mask) {
+    m_mask = (HistoryWord *)malloc(LINES_PER_ROTATION * GUARD_ZONE_WORDS * sizeof(HistoryWord));
+    if (!m_mask) {
+      wxLogError(wxT("BR24radar_pi: Out of memory"));
+      m_type = GZ_OFF;
+      return;
+    }
+  }
+  memset(m_mask, 0, LINES_PER_ROTATION * GUARD_ZONE_WORDS * sizeof(HistoryWord));
+
+  for (size_t c = 0; c < m_polygon_corners; c++) {
+    x[c] = m_polygon[c].range * cos(deg2rad(m_polygon[c].bearing));
+    y[c] = m_polygon[c].range * sin(deg2rad(m_polygon[c].bearing));
+  }
+
+  double returns_per_meter = (double)len / range;
+
+  for (SpokeBearing angle = 0; angle < LINES_PER_ROTATION; angle++) {
+    double dx = cos(deg2rad(SCALE_RAW_TO_DEGREES2048(angle)));
+    double dy = sin(deg2rad(SCALE_RAW_TO_DEGREES2048(angle)));
+    size_t crossings = GuardZonePolygonCrossings(x, y, m_polygon_corners, dx, dy, crossing);
+
+    HistoryWord *mask = m_mask + angle * GUARD_ZONE_WORDS;
+    for (size_t i = 0; i + 1 < crossings; i += 2) {
+      double first = ceil(crossing[i] * returns_per_meter - 0.5);
+      double last = floor(crossing[i + 1] * returns_per_meter - 0.5);
+      for (double r = wxMax(first, 0.0); r <= last && r < len; r++) {
+        size_t bit = (size_t)r;
+        mask[bit / HISTORY_WORD_BITS] |= (HistoryWord)1 << (bit % HISTORY_WORD_BITS);
       }
-      break;
-
-    case GZ_CIRCLE:
-      if (range_start < RETURNS_PER_LINE) {
-        if (range_end > RETURNS_PER_LINE) {
-          range_end = RETURNS_PER_LINE;
-        }
-
-        for (size_t r = range_start; r <= range_end; r++) {
-          if (!m_multi_sweep_filter || HISTORY_FILTER_ALLOW(hist[r])) {
-            if (data[r] >= m_pi->m_settings.threshold_blue) {
-              m_running_count++;
-            }
+    }
+  }
+}
+
+/*
+ * Count the returns in the zone. strong has a bit for every return that is at least
+ * threshold_blue, allow the returns that pass the multi sweep filter (or is null when
+ * the filter was not computed.)
+ */
+int GuardZone::ProcessSpoke(SpokeBearing angle, UINT8* data, const HistoryWord* strong, const HistoryWord* allow, size_t len,
+                            int range) {
+  const HistoryWord* filter = m_multi_sweep_filter ? allow : 0;
+
+  if (range <= 0 || len == 0 || angle < 0 || angle >= LINES_PER_ROTATION) {
+    return -1;
+  }
+  if (!IsCompiled(range, len)) {
+    Compile(range, len);
+  }
+
+  if (m_type == GZ_POLYGON) {
+    m_running_count += HistoryCountMask(strong, filter, m_mask + angle * GUARD_ZONE_WORDS, HISTORY_WORDS(len));
+  } else {
+    m_running_count += HistoryCount(strong, filter, m_first[angle], m_last[angle]);
 #ifdef TEST_GUARD_ZONE_LOCATION
-            // Zap guard zone computation location to green so this is visible on screen
-            else {
-              data[r] = m_pi->m_settings.threshold_green;
-            }
+    if (m_first[angle] <= m_last[angle]) {
+      MarkLocation(data, strong, filter, m_first[angle], m_last[angle], m_pi->m_settings.threshold_green);
+    }
 #endif
-          }
-        }
-        if (angle > m_last_angle) {
-          in_guard_zone = true;
-        }
-      }
-      break;
-
-    default:
-      in_guard_zone = false;
-      break;
   }
 
+  // An arc is swept while the line is in it; a circle or polygon from one pass through
+  // north to the next. A line that is received again does not end it.
+  bool in_guard_zone = m_sweeps[angle] && (m_type == GZ_ARC || angle >= m_last_angle);
+
+  int completed = -1;
+
   if (m_last_in_guard_zone && !in_guard_zone) {
     // last bearing that could add to m_running_count, so store as bogey_count;
     m_bogey_count = m_running_count;
     m_running_count = 0;
+    completed = m_bogey_count;
     LOG_GUARD(wxT("%s angle=%d last_angle=%d range=%d guardzone=%d..%d (%d - %d) bogey_count=%d"), m_log_name.c_str(), angle,
-              m_last_angle, range, range_start, range_end, m_inner_range, m_outer_range, m_bogey_count);
+              m_last_angle, range, m_first[angle], m_last[angle], m_inner_range, m_outer_range, m_bogey_count);
 
     // When debugging with a static ship it is hard to find moving targets, so move
     // the guard zone instead. This slowly rotates the guard zone.
@@ -115,6 +250,7 @@ void GuardZone::ProcessSpoke(SpokeBearing angle, UINT8* data, UINT8* hist, size_
 
   m_last_in_guard_zone = in_guard_zone;
   m_last_angle = angle;
+  return completed;
 }
 
 PLUGIN_END_NAMESPACE
@@ -33,9 +33,27 @@
 #define _GUARDZONE_H_
 
 #include "br24radar_pi.h"
+#include "RadarGeometry.h"
+#include "SweepHistory.h"
+#include "GuardZonePolygon.h"
 
 PLUGIN_BEGIN_NAMESPACE
 
+#define GUARD_ZONE_CORNERS_MAX (32)                           // Most corners of a polygon zone
+#define GUARD_ZONE_WORDS (HISTORY_WORDS(MAX_GEOMETRY_RETURNS))  // Words of a polygon zone mask line
+
+// A corner of a polygon zone, relative to the boat like the other zones
+struct GuardZoneCorner {
+  double bearing;  // degrees
+  int range;       // meters
+};
+
+/*
+ * A guard zone counts the returns inside it during one sweep. The zone is compiled for
+ * the range and spoke length it is used with: an arc or circle into the first and last
+ * return of each line, a polygon into a mask of the returns of each line. Counting a
+ * spoke is then a popcount of the words of the history plane that the zone covers.
+ */
 class GuardZone {
  public:
   GuardZoneType m_type;
@@ -44,6 +62,8 @@ class GuardZone {
   int m_inner_range;  // start in meters
   int m_outer_range;  // end   in meters
   int m_multi_sweep_filter;
+  GuardZoneCorner m_polygon[GUARD_ZONE_CORNERS_MAX];  // For GZ_POLYGON, in order around the zone
+  size_t m_polygon_corners;
 
   void ResetBogeys() {
     m_bogey_count = -1;
@@ -76,11 +96,17 @@ class GuardZone {
     m_multi_sweep_filter = filter;
     ResetBogeys();
   };
+  // Corners as "bearing,range;bearing,range;..." in degrees and meters. False when malformed.
+  bool SetPolygon(const wxString &corners);
+  wxString GetPolygon();
 
   /*
-   * Check if data is in this GuardZone, if so update bogeyCount
+   * Check if data is in this GuardZone, if so update bogeyCount. Returns the bogey count
+   * when this spoke completed the sweep of the zone, -1 otherwise.
    */
-  void ProcessSpoke(SpokeBearing angle, UINT8 *data, UINT8 *hist, size_t len, int range);
+  int ProcessSpoke(SpokeBearing angle, UINT8 *data, const HistoryWord *strong, const HistoryWord *allow, size_t len, int range);
+
+  void RenderPolygon();
 
   int GetBogeyCount() {
     if (m_bogey_count > -1) {
@@ -100,11 +126,19 @@ class GuardZone {
     m_inner_range = 0;
     m_outer_range = 0;
     m_multi_sweep_filter = 0;
+    m_polygon_corners = 0;
+    m_polygon_version = 0;
+
+    memset(&m_compiled, 0, sizeof(m_compiled));
+    m_mask = 0;
 
     ResetBogeys();
   }
 
-  ~GuardZone() { LOG_VERBOSE(wxT("%s destroyed"), m_log_name.c_str()); }
+  ~GuardZone() {
+    free(m_mask);
+    LOG_VERBOSE(wxT("%s destroyed"), m_log_name.c_str());
+  }
 
  private:
   br24radar_pi *m_pi;
@@ -114,6 +148,30 @@ class GuardZone {
   int m_bogey_count;    // complete cycle
   int m_running_count;  // current swipe
 
+  // What the zone was compiled for. The public fields are also set directly, so they are
+  // compared on every spoke rather than compiled by the setters.
+  struct Shape {
+    GuardZoneType type;
+    SpokeBearing start_bearing;
+    SpokeBearing end_bearing;
+    int inner_range;
+    int outer_range;
+    unsigned polygon_version;
+    int range;
+    size_t len;
+  };
+  Shape m_compiled;
+  unsigned m_polygon_version;  // Changed by SetPolygon()
+
+  UINT16 m_first[LINES_PER_ROTATION];  // Arc and circle: returns [m_first, m_last] of each line,
+  UINT16 m_last[LINES_PER_ROTATION];   // none when m_first > m_last
+  UINT8 m_sweeps[LINES_PER_ROTATION];  // Lines that take part in the sweep of an arc or circle
+  HistoryWord *m_mask;                 // Polygon: GUARD_ZONE_WORDS words for each line
+
+  bool IsCompiled(int range, size_t len);
+  void Compile(int range, size_t len);
+  void CompilePolygon(int range, size_t len);
+
   void UpdateSettings();
 };
 
@@ -0,0 +1,89 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _GUARD_ZONE_ALARM_H_
+#define _GUARD_ZONE_ALARM_H_
+
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define GUARD_ZONE_EVENTS_SIZE (64)  // Alarms waiting for the GUI thread, must be a power of 2
+
+// A guard zone that finished its sweep with more bogeys than guard_zone_threshold
+struct GuardZoneEvent {
+  int zone;
+  int bogeys;
+  uint64_t sweep_nanos;  // MonotonicNanos() when the last spoke of the sweep was processed
+};
+
+/*
+ * Bounded single producer / single consumer queue of guard zone alarms. The spoke
+ * pipeline of the radar pushes (it runs with RadarInfo::m_exclusive held, so there is
+ * one producer at a time), the GUI thread pops; the indices are handed over with
+ * release stores and acquire loads like CRMPacketRing, so the processing thread never
+ * waits for the GUI. When the queue is full new alarms are dropped, the 1 Hz check in
+ * br24radar_pi::Notify() still sees the bogey counts.
+ */
+class GuardZoneEventQueue {
+ public:
+  GuardZoneEventQueue() : m_head(0), m_tail(0) {}
+
+  // Producer side
+  bool Push(const GuardZoneEvent &event) {
+    if (m_head - __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE) >= GUARD_ZONE_EVENTS_SIZE) {
+      return false;
+    }
+    m_events[m_head & (GUARD_ZONE_EVENTS_SIZE - 1)] = event;
+    __atomic_store_n(&m_head, m_head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+  // Consumer side
+  bool Pop(GuardZoneEvent *event) {
+    if (__atomic_load_n(&m_head, __ATOMIC_ACQUIRE) == m_tail) {
+      return false;
+    }
+    *event = m_events[m_tail & (GUARD_ZONE_EVENTS_SIZE - 1)];
+    __atomic_store_n(&m_tail, m_tail + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+ private:
+  size_t m_head;                    // written by producer only
+  char m_pad[64 - sizeof(size_t)];  // keep head and tail on separate cache lines
+  size_t m_tail;                    // written by consumer only
+  GuardZoneEvent m_events[GUARD_ZONE_EVENTS_SIZE];
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _GUARD_ZONE_ALARM_H_ */
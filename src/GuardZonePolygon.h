@@ -0,0 +1,84 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _GUARD_ZONE_POLYGON_H_
+#define _GUARD_ZONE_POLYGON_H_
+
+#include <stddef.h>
+
+/*
+ * Where the line from the boat in direction (dx, dy) is inside the polygon of n corners
+ * (x[], y[]), relative to the boat. Sets crossing[] to the distances along the line at
+ * which it goes in and out, in pairs and in order, and returns how many there are.
+ * crossing[] must have room for n + 1.
+ *
+ * An edge is crossed when its corners are on different sides of the line, a corner on
+ * the line counting as the right hand side. So a line through a corner where the
+ * polygon only touches it crosses twice or not at all. When the boat is inside the
+ * polygon the line leaves it once more than it goes in, and the first pair starts at 0.
+ */
+inline size_t GuardZonePolygonCrossings(const double *x, const double *y, size_t n, double dx, double dy,
+                                        double *crossing) {
+  size_t crossings = 0;
+
+  for (size_t c = 0; c < n; c++) {
+    size_t d = (c + 1) % n;
+    bool left_c = dx * y[c] - dy * x[c] > 0.0;
+    bool left_d = dx * y[d] - dy * x[d] > 0.0;
+    if (left_c == left_d) {
+      continue;  // Also every edge parallel to the line
+    }
+    double ex = x[d] - x[c];
+    double ey = y[d] - y[c];
+    double t = (ex * y[c] - ey * x[c]) / (ex * dy - ey * dx);  // Distance along the line
+    if (t >= 0.0) {
+      crossing[crossings++] = t;
+    }
+  }
+  for (size_t i = 1; i < crossings; i++) {  // Insertion sort, there are only a few
+    double t = crossing[i];
+    size_t j = i;
+    for (; j > 0 && crossing[j - 1] > t; j--) {
+      crossing[j] = crossing[j - 1];
+    }
+    crossing[j] = t;
+  }
+  if (crossings % 2) {
+    for (size_t j = crossings; j > 0; j--) {
+      crossing[j] = crossing[j - 1];
+    }
+    crossing[0] = 0.0;
+    crossings++;
+  }
+  return crossings;
+}
+
+#endif /* _GUARD_ZONE_POLYGON_H_ */
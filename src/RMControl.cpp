@@ -32,14 +32,15 @@
  */
 
 #include "RMControl.h"
+#include "RMProtocol.h"
+#include "RMScanFrame.h"
+#include "RMUnpack.h"
+#include <errno.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
 PLUGIN_BEGIN_NAMESPACE
 
-#define SEATALK_HS_ANNOUNCE_GROUP	"224.0.0.1"
-#define SEATALK_HS_ANNOUNCE_PORT	5800
-
 /*
  * This file not only contains the radar receive threads, it is also
  * the only unit that understands what the radar returned data looks like.
@@ -47,24 +48,28 @@ PLUGIN_BEGIN_NAMESPACE
  */
 
 CRMControl::CRMControl(br24radar_pi *pi, RadarInfo *ri)
-	: wxThread(wxTHREAD_JOINABLE)
-	, m_pi(pi)
-	, m_ri(ri)
-	, m_quit(false)
-	, m_haveRadar(false)
+	: m_total_spokes(0)
 	, m_mcast_addr(0)
-	, m_range_meters(0)
-	, m_updated_range(false)
-	, m_radar_status(0)
+	, m_haveRadar(false)
 	, m_dataSocket(INVALID_SOCKET)
 	, m_new_ip_addr(false)
-	, m_interface_array(0)
-	, m_interface(0)
+	, m_range_meters(0)
+	, m_updated_range(false)
 	, m_next_spoke(-1)
 	, m_next_rotation(0)
+	, m_pi(pi)
+	, m_ri(ri)
+	, m_quit(false)
+	, m_reactor_slot(-1)
+	, m_reportSocket(INVALID_SOCKET)
+	, m_no_data_timeout(0)
+	, m_rx_seen(false)
+	, m_command_count(0)
+	, m_interface_array(0)
+	, m_interface(0)
+	, m_radar_status(0)
+	, m_process_thread(0)
 {
-	Create(1024 * 1024);  // Stack size, be liberal
-
 	if (m_pi->m_settings.verbose >= 2) 
 	{
 		wxLogMessage(wxT("RMRadar_pi: CRMControl ctor"));
@@ -83,15 +88,22 @@ CRMControl::CRMControl(br24radar_pi *pi, RadarInfo *ri)
 	m_displayTiming.SetMin(0); m_displayTiming.SetMax(255);
 	m_mbsEnabled.SetMin(0); m_mbsEnabled.SetMax(1);
 	m_stcCurve.SetMin(1); m_stcCurve.SetMax(8);
+
+#ifdef __linux__
+	memset(m_rx_msgs, 0, sizeof(m_rx_msgs));
+	for (int i = 0; i < RECEIVE_BATCH_MAX; i++)
+	{
+		m_rx_iov[i].iov_len = RECEIVE_BUFFER_SIZE;
+		m_rx_msgs[i].msg_hdr.msg_iov = &m_rx_iov[i];
+		m_rx_msgs[i].msg_hdr.msg_iovlen = 1;
+		m_rx_msgs[i].msg_hdr.msg_name = &m_rx_from[i];
+	}
+#endif
 }
 
 CRMControl::~CRMControl() 
 { 
-	wxLogMessage(wxT("RMRadar_pi: %s thread is stopping"), m_ri->m_name.c_str());
-}
-
-void CRMControl::OnExit()
-{
+	wxLogMessage(wxT("RMRadar_pi: %s control is stopping"), m_ri->m_name.c_str());
 }
 
 void CRMControl::logBinaryData(const wxString &what, const UINT8 *data, int size) 
@@ -131,17 +143,17 @@ void CRMControl::ProcessFrame(const UINT8 *data, int len)
 		memcpy(&msgId, data, sizeof(msgId));
 		switch(msgId)
 		{
-		case 0x00010001:
+		case RM_MSG_FEEDBACK:
 			ProcessFeedback(data, len);
 			break;
-		case 0x00010002:
+		case RM_MSG_PRESET_FEEDBACK:
 			ProcessPresetFeedback(data, len);
 			break;
-		case 0x00010003:
+		case RM_MSG_SCAN_DATA:
 			ProcessScanData(data, len);
 			m_ri->m_data_timeout = now + DATA_TIMEOUT;
 			break;
-		case 0x00010005:
+		case RM_MSG_CURVE_FEEDBACK:
 			ProcessCurveFeedback(data, len);
 			break;
 		case 0x00010006:
@@ -225,6 +237,189 @@ void CRMControl::EmulateFakeBuffer(void) {
   LOG_VERBOSE(wxT("BR24radar_pi: emulating %d spokes at range %d with %d spots"), scanlines_in_packet, range_meters, spots);
 }
 
+/*
+ * Drain up to count datagrams from the socket into buffers[], each of which
+ * holds RECEIVE_BUFFER_SIZE bytes; the sizes are returned in m_rx_size and
+ * the senders in m_rx_from. When a capture is running the datagrams are passed
+ * to the recorder as well.
+ * On Linux this is a single recvmmsg() call; elsewhere, or when the batch size
+ * is 1, it falls back to one recv() per wakeup as before. Neither ever blocks,
+ * the reactor thread serves all radars.
+ * Returns the number of datagrams received, 0 if nothing was waiting after all,
+ * or -1 on a socket error.
+ */
+int CRMControl::ReceiveBatch(SOCKET socket, UINT8 **buffers, int count)
+{
+	int batch = MAX(MIN(MIN(m_pi->m_settings.receive_batch_size, count), RECEIVE_BATCH_MAX), 1);
+	int r;
+
+#ifdef __linux__
+	if (batch > 1)
+	{
+		for (int i = 0; i < batch; i++)
+		{
+			m_rx_iov[i].iov_base = buffers[i];
+			m_rx_msgs[i].msg_hdr.msg_namelen = sizeof(m_rx_from[i]);
+		}
+		r = recvmmsg(socket, m_rx_msgs, batch, MSG_DONTWAIT, 0);
+		m_ri->m_statistics.receive_syscalls++;
+		if (r < 0)
+		{
+			return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+		}
+		for (int i = 0; i < r; i++)
+		{
+			m_rx_size[i] = (int)m_rx_msgs[i].msg_len;
+		}
+	}
+	else
+#endif
+	{
+		socklen_t from_len = sizeof(m_rx_from[0]);
+		r = recvfrom(socket, (char *)buffers[0], RECEIVE_BUFFER_SIZE, MSG_DONTWAIT, (struct sockaddr *)&m_rx_from[0],
+			&from_len);
+		m_ri->m_statistics.receive_syscalls++;
+		if (r < 0)
+		{
+			return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+		}
+		if (r == 0)
+		{
+			return -1;  // An empty datagram is not something a radar sends
+		}
+		m_rx_size[0] = r;
+		r = 1;
+	}
+	if (r == 0)
+	{
+		return 0;
+	}
+	m_ri->m_statistics.receive_batches++;
+	m_ri->m_statistics.receive_datagrams += r;
+
+	if (m_pi->m_recorder && m_pi->m_recorder->IsRecording())
+	{
+		uint64_t now = CRMRecorder::Timestamp();
+		for (int i = 0; i < r; i++)
+		{
+			m_pi->m_recorder->Record(m_ri->m_radar, buffers[i], m_rx_size[i], &m_rx_from[i], &m_radar_mcast, now);
+		}
+	}
+	return r;
+}
+
+/*
+ * Called on the reactor thread when the data socket is readable. Only reads,
+ * all decoding is done by the processing thread.
+ */
+void CRMControl::OnDataReadable(void)
+{
+	wxCriticalSectionLocker lock(m_producer_lock);
+	UINT8 *buffers[RECEIVE_BATCH_MAX];
+	int slots = (int)MIN(m_ring.FreeSlots(), (size_t)RECEIVE_BATCH_MAX);
+	int r;
+
+	if (slots > 0)
+	{
+		for (int i = 0; i < slots; i++)
+		{
+			buffers[i] = m_ring.WriteSlot(i)->data;
+		}
+		r = ReceiveBatch(m_dataSocket, buffers, slots);
+		if (r > 0)
+		{
+			for (int i = 0; i < r; i++)
+			{
+				m_ring.WriteSlot(i)->len = m_rx_size[i];
+			}
+			int used = (int)m_ring.Publish(r);
+			if (used > m_ri->m_statistics.ring_high_water)
+			{
+				m_ri->m_statistics.ring_high_water = used;
+			}
+			m_process_wakeup.Post();
+		}
+	}
+	else
+	{
+		// Processing is behind and the ring is full. Keep draining the socket: the ring keeps
+		// the older packets and the newest datagrams are dropped here, counted in ring_overflows,
+		// and not unseen in the kernel.
+		for (int i = 0; i < RECEIVE_BATCH_MAX; i++)
+		{
+			buffers[i] = m_rx_arena[i];
+		}
+		r = ReceiveBatch(m_dataSocket, buffers, RECEIVE_BATCH_MAX);
+		if (r > 0)
+		{
+			m_ri->m_statistics.ring_overflows += r;
+		}
+	}
+
+	m_ri->m_statistics.receive_syscalls++;  // Our share of the epoll_wait() that woke us
+	m_rx_seen = true;
+	m_no_data_timeout = -15;
+
+	if (r < 0)
+	{
+		m_pi->m_reactor->Unwatch(m_dataSocket);
+		closesocket(m_dataSocket);
+		m_dataSocket = INVALID_SOCKET;
+		wxLogMessage(wxT("RMRadar_pi: %s illegal frame"), m_ri->m_name.c_str());
+	}
+}
+
+/*
+ * Queue a frame from another source than the data socket, i.e. CRMReplay.
+ * Returns false when the packet ring is full; the caller decides whether to
+ * wait or drop.
+ */
+bool CRMControl::InjectFrame(const UINT8 *data, int len)
+{
+	wxCriticalSectionLocker lock(m_producer_lock);
+
+	if (len > RECEIVE_BUFFER_SIZE || m_ring.FreeSlots() == 0)
+	{
+		return false;
+	}
+	CRMPacket *packet = m_ring.WriteSlot(0);
+	memcpy(packet->data, data, len);
+	packet->len = len;
+	m_ring.Publish(1);
+	m_process_wakeup.Post();
+	return true;
+}
+
+CRMProcessThread::CRMProcessThread(CRMControl *control)
+	: wxThread(wxTHREAD_JOINABLE)
+	, m_control(control)
+	, m_quit(false)
+{
+	Create(1024 * 1024);  // Stack size, be liberal
+}
+
+void *CRMProcessThread::Entry(void)
+{
+	CRMPacketRing &ring = m_control->m_ring;
+
+	while (!m_quit)
+	{
+		m_control->m_process_wakeup.WaitTimeout(1000);
+
+		size_t n;
+		while (!m_quit && (n = ring.Available()) > 0)
+		{
+			for (size_t i = 0; i < n && !m_quit; i++)
+			{
+				CRMPacket *packet = ring.ReadSlot(i);
+				m_control->ProcessFrame(packet->data, packet->len);
+			}
+			ring.Consume(n);
+		}
+	}
+	return 0;
+}
+
 SOCKET CRMControl::PickNextEthernetCard()
 {
 	SOCKET socket = INVALID_SOCKET;
@@ -315,292 +510,223 @@ SOCKET CRMControl::GetNewDataSocket()
 	return socket;
 }
 
-void *CRMControl::Entry(void)
+void CRMControl::Start(void)
 {
-	int r = 0;
-	int no_data_timeout = 0;
-
-	union {
-		sockaddr_storage addr;
-		sockaddr_in ipv4;
-	} rx_addr;
+	if (m_pi->m_settings.verbose)
+	{
+		wxLogMessage(wxT("RMRadar_pi: CRMControl %s starting"), m_ri->m_name.c_str());
+	}
 
-	socklen_t rx_len;
-	UINT8 *a = (UINT8 *)&rx_addr.ipv4.sin_addr;  // sin_addr is in network layout
+	if (m_pi->m_settings.verbose)
+	{
+		wxLogMessage(wxT("RMRadar_pi: CRMControl %s using %s scan data unpacker"), m_ri->m_name.c_str(),
+		             wxString::FromAscii(RMUnpackKernelName()).c_str());
+	}
+	m_process_thread = new CRMProcessThread(this);
+	m_process_thread->Run();
+}
 
-	UINT8 data[2048/*sizeof(radar_frame_pkt)*/];
-	m_interface_array = 0;
-	m_interface = 0;
-	static struct sockaddr_in mcastFoundAddr;
-	static struct sockaddr_in radarFoundAddr;
+void CRMControl::CloseSockets(void)
+{
+	if (m_dataSocket != INVALID_SOCKET)
+	{
+		m_pi->m_reactor->Unwatch(m_dataSocket);
+		closesocket(m_dataSocket);
+		m_dataSocket = INVALID_SOCKET;
+	}
+	if (m_reportSocket != INVALID_SOCKET)
+	{
+		m_pi->m_reactor->Unwatch(m_reportSocket);
+		closesocket(m_reportSocket);
+		m_reportSocket = INVALID_SOCKET;
+	}
+}
 
-	// SOCKET dataSocket = INVALID_SOCKET;
-	// SOCKET commandSocket = INVALID_SOCKET;
-	SOCKET reportSocket = INVALID_SOCKET;
+void CRMControl::Stop(void)
+{
+	m_quit = true;
+	CloseSockets();
 
-	if (m_pi->m_settings.verbose) {
-		wxLogMessage(wxT("RMRadar_pi: CRMControl thread %s starting"), m_ri->m_name.c_str());
+	if (m_interface_array)
+	{
+		freeifaddrs(m_interface_array);
+		m_interface_array = 0;
+		m_interface = 0;
 	}
 
-	fprintf(stderr, "RMRadar_pi: CRMControl thread starting\n");
+	if (m_process_thread)
+	{
+		m_process_thread->Shutdown();
+		m_process_wakeup.Post();
+		m_process_thread->Wait();
+		delete m_process_thread;
+		m_process_thread = 0;
+	}
+}
 
-	socketReady(INVALID_SOCKET, 1000);  // sleep for 1s so that other stuff is set up (fixes Windows core on startup)
+/*
+ * Called once per REACTOR_TICK_MILLIS on the reactor thread. Does what the old
+ * receive loop did on every select() timeout: keepalives, (re)opening the report
+ * socket and dropping the sockets when the radar has gone quiet.
+ */
+void CRMControl::Tick(void)
+{
+	if (m_pi->m_settings.emulator_on)
+	{
+		EmulateFakeBuffer();
+		return;
+	}
+	if (m_pi->m_settings.replay_on)
+	{
+		// CRMReplay is feeding the packet ring, leave the network alone
+		CloseSockets();
+		m_haveRadar = false;
+		return;
+	}
 
-	while (!m_quit)
+	if (m_reportSocket == INVALID_SOCKET)
 	{
-		if (m_pi->m_settings.emulator_on) 
+		m_reportSocket = PickNextEthernetCard();
+		if (m_reportSocket != INVALID_SOCKET)
 		{
-			socketReady(INVALID_SOCKET, 1000);  // sleep for 1s
-			EmulateFakeBuffer();
-			continue;
+			m_pi->m_reactor->Watch(m_reportSocket, this, CRMReactor::WATCH_REPORT);
+			m_no_data_timeout = -10;
 		}
+	}
 
-		if (reportSocket == INVALID_SOCKET) 
-		{
-			reportSocket = PickNextEthernetCard();
-			if (reportSocket != INVALID_SOCKET)
-			{
-				no_data_timeout = -10;
-			}
-		} 
-
-		struct timeval tv = {(long)1, (long)0};
-
-		fd_set fdin;
-		FD_ZERO(&fdin);
-
-		int maxFd = INVALID_SOCKET;
-		if (reportSocket != INVALID_SOCKET)
+	time_t now = time(0);
+	if(m_haveRadar && m_pi->m_settings.enable_transmit)
+	{
+		if(now >= m_lastKeepalive1s)
 		{
-			FD_SET(reportSocket, &fdin);
-			maxFd = MAX(reportSocket, maxFd);
+			Send1sKeepalive();
+			m_lastKeepalive1s = now + 1;
 		}
-		if (m_dataSocket != INVALID_SOCKET)
+		if(now >= m_lastKeepalive5s)
 		{
-			FD_SET(m_dataSocket, &fdin);
-			maxFd = MAX(m_dataSocket, maxFd);
+			Send5sKeepalive();
+			m_lastKeepalive5s = now + 5;
 		}
+	}
 
-		r = select(maxFd + 1, &fdin, 0, 0, &tv);
+	if (!m_rx_seen)
+	{
+		m_no_data_timeout++;
+	}
+	m_rx_seen = false;
 
-		if (m_quit) 
+	if (m_no_data_timeout >= 2)
+	{
+		m_no_data_timeout = 0;
+		if (m_reportSocket != INVALID_SOCKET) 
 		{
-			break;
+			m_ri->m_state.Update(RADAR_OFF);
+			m_mcast_addr = 0;
+			// m_radar_addr = 0;
+			m_haveRadar = false;
 		}
+		CloseSockets();
+	}
+}
+
+void CRMControl::OnReportReadable(void)
+{
+	union {
+		sockaddr_storage addr;
+		sockaddr_in ipv4;
+	} rx_addr;
+	socklen_t rx_len = sizeof(rx_addr);
+	UINT8 *a = (UINT8 *)&rx_addr.ipv4.sin_addr;  // sin_addr is in network layout
+	UINT8 data[RECEIVE_BUFFER_SIZE];
 
-		time_t now = time(0);
-		if(m_haveRadar && m_pi->m_settings.enable_transmit)
+	m_rx_seen = true;
+
+	int r = recvfrom(m_reportSocket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
+	if (r > 0)
+	{
+		if (m_pi->m_recorder && m_pi->m_recorder->IsRecording())
 		{
-			if(now >= m_lastKeepalive1s)
-			{
-				Send1sKeepalive();
-				m_lastKeepalive1s = now + 1;
-			}
-			if(now >= m_lastKeepalive5s)
-			{
-				Send5sKeepalive();
-				m_lastKeepalive5s = now + 5;
-			}
+			struct sockaddr_in announce;
+			memset(&announce, 0, sizeof(announce));
+			announce.sin_family = AF_INET;
+			announce.sin_addr.s_addr = inet_addr(SEATALK_HS_ANNOUNCE_GROUP);
+			announce.sin_port = htons(SEATALK_HS_ANNOUNCE_PORT);
+			m_pi->m_recorder->Record(m_ri->m_radar, data, r, &rx_addr.ipv4, &announce, CRMRecorder::Timestamp());
 		}
 
-		if (r > 0) 
+		if (ProcessReport(data, r))
 		{
-			if (m_dataSocket != INVALID_SOCKET && FD_ISSET(m_dataSocket, &fdin)) 
+			memcpy(&m_mcast_found_addr, m_interface->ifa_addr, sizeof(m_mcast_found_addr));
+			m_mcast_addr = &m_mcast_found_addr;
+			wxString addr;
+			addr.Printf(wxT("%u.%u.%u.%u"), a[0], a[1], a[2], a[3]);
+			m_pi->m_pMessageBox->SetRadarIPAddress(addr);
+			if (m_ri->m_state.value == RADAR_OFF)
 			{
-				rx_len = sizeof(rx_addr);
-				r = recvfrom(m_dataSocket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
-				if (r > 0) 
+				if (m_pi->m_settings.verbose)
 				{
-					ProcessFrame(data, r);
-					no_data_timeout = -15;
-				} 
-				else 
-				{
-					closesocket(m_dataSocket);
-					m_dataSocket = INVALID_SOCKET;
-					wxLogMessage(wxT("RMRadar_pi: %s at %u.%u.%u.%u illegal frame"), m_ri->m_name.c_str(), a[0], a[1], a[2], a[3]);
+					wxLogMessage(wxT("RMRadar_pi: %s detected at %s"), m_ri->m_name.c_str(), addr.c_str());
 				}
+				m_ri->m_state.Update(RADAR_STANDBY);
 			}
+			m_ri->m_radar_timeout = time(0) + WATCHDOG_TIMEOUT;
+			m_no_data_timeout++; // Make sure we do get some data
 
-			if (reportSocket != INVALID_SOCKET && FD_ISSET(reportSocket, &fdin))
+			if (m_dataSocket == INVALID_SOCKET)
 			{
-				rx_len = sizeof(rx_addr);
-				r = recvfrom(reportSocket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
-				if (r > 0)
+				m_dataSocket = GetNewDataSocket();
+				if (m_dataSocket != INVALID_SOCKET)
 				{
-					if (ProcessReport(data, r))
-					{
-						memcpy(&mcastFoundAddr, m_interface->ifa_addr, sizeof(mcastFoundAddr));
-						m_mcast_addr = &mcastFoundAddr;
-						memcpy(&radarFoundAddr, &rx_addr, sizeof(radarFoundAddr));
-						// m_radar_addr = &radarFoundAddr;
-						wxString addr;
-						addr.Printf(wxT("%u.%u.%u.%u"), a[0], a[1], a[2], a[3]);
-						m_pi->m_pMessageBox->SetRadarIPAddress(addr);
-						if (m_ri->m_state.value == RADAR_OFF)
-						{
-							if (m_pi->m_settings.verbose)
-							{
-								wxLogMessage(wxT("RMRadar_pi: %s detected at %s"), m_ri->m_name.c_str(), addr.c_str());
-							}
-							m_ri->m_state.Update(RADAR_STANDBY);
-						}
-						m_ri->m_radar_timeout = time(0) + WATCHDOG_TIMEOUT;
-						no_data_timeout++; // Make sure we do get some data
-
-						if (m_dataSocket == INVALID_SOCKET)
-						{
-							m_dataSocket = GetNewDataSocket();
-							m_lastKeepalive1s = time(0) + 1;
-							m_lastKeepalive5s = m_lastKeepalive1s + 4;
-							SendInitMessages();
-						}
-					}
-				} 
-				else 
-				{
-					wxLogMessage(wxT("RMRadar_pi: %s at %u.%u.%u.%u illegal report"), m_ri->m_name.c_str(), a[0], a[1], a[2], a[3]);
-					closesocket(reportSocket);
-					reportSocket = INVALID_SOCKET;
+					m_pi->m_reactor->Watch(m_dataSocket, this, CRMReactor::WATCH_DATA);
 				}
+				m_lastKeepalive1s = time(0) + 1;
+				m_lastKeepalive5s = m_lastKeepalive1s + 4;
+				SendInitMessages();
 			}
-		} 
-		else 
-		{
-			no_data_timeout++;
 		}
+	} 
+	else 
+	{
+		wxLogMessage(wxT("RMRadar_pi: %s at %u.%u.%u.%u illegal report"), m_ri->m_name.c_str(), a[0], a[1], a[2], a[3]);
+		m_pi->m_reactor->Unwatch(m_reportSocket);
+		closesocket(m_reportSocket);
+		m_reportSocket = INVALID_SOCKET;
+	}
+}
+
+/*
+ * Queue a control message for the reactor thread. Called from the GUI thread.
+ */
+void CRMControl::SendCommand(const uint8_t *msg, size_t len)
+{
+	{
+		wxCriticalSectionLocker lock(m_command_lock);
 
-		if (no_data_timeout >= 2)
+		if (len > COMMAND_MAX_SIZE || m_command_count >= COMMAND_QUEUE_SIZE)
 		{
-			no_data_timeout = 0;
-			if (m_dataSocket != INVALID_SOCKET)
-			{
-				closesocket(m_dataSocket);
-				m_dataSocket = INVALID_SOCKET;
-			}
-			if (reportSocket != INVALID_SOCKET) 
-			{
-				closesocket(reportSocket);
-				reportSocket = INVALID_SOCKET;
-				m_ri->m_state.Update(RADAR_OFF);
-				m_mcast_addr = 0;
-				// m_radar_addr = 0;
-				m_haveRadar = false;
-			}
+			wxLogMessage(wxT("RMRadar_pi: %s control message dropped"), m_ri->m_name.c_str());
+			return;
 		}
+		m_commands[m_command_count].len = len;
+		memcpy(m_commands[m_command_count].data, msg, len);
+		m_command_count++;
 	}
+	m_pi->m_reactor->Wakeup();
+}
 
-	if (m_dataSocket != INVALID_SOCKET)
-	{
-		closesocket(m_dataSocket);
-	}
-	if (reportSocket != INVALID_SOCKET)
-	{
-		closesocket(reportSocket);
-	}
+void CRMControl::SendPendingCommands(void)
+{
+	wxCriticalSectionLocker lock(m_command_lock);
 
-	if (m_interface_array)
+	for (int i = 0; i < m_command_count; i++)
 	{
-		freeifaddrs(m_interface_array);
+		sendto(m_dataSocket, m_commands[i].data, m_commands[i].len, 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
 	}
-	return 0;
+	m_command_count = 0;
 }
 
-//
-// The following is the received radar state. It sends this regularly
-// but especially after something sends it a state change.
-//
-#pragma pack(push, 1)
-
-struct SRadarFeedback {
-	uint32_t type;	// 0x010001
-	uint32_t range_values[11];
-	uint32_t something_1[33]; 
-	uint8_t status;		// 2 - warmup, 1 - transmit, 0 - standby, 6 - shutting down (warmup time - countdown), 3 - shutdown
-	uint8_t something_2[3];
-	uint8_t warmup_time;
-	uint8_t signal_strength;	// number of bars
-	uint8_t something_3[7];
-	uint8_t range_id;
-	uint8_t something_4[2];
-	uint8_t auto_gain;
-	uint8_t something_5[3];
-	uint32_t gain;
-	uint8_t auto_sea; // 0 - disabled; 1 - harbour, 2 - offshore, 3 - coastal 
-	uint8_t something_6[3];
-	uint8_t sea_value;
-	uint8_t rain_enabled;
-	uint8_t something_7[3];
-	uint8_t rain_value;
-	uint8_t ftc_enabled;
-	uint8_t something_8[3];
-	uint8_t ftc_value;
-	uint8_t auto_tune;
-	uint8_t something_9[3];
-	uint8_t tune;
-	int16_t bearing_offset;	// degrees * 10; left - negative, right - positive
-	uint8_t interference_rejection;
-	uint8_t something_10[3];
-	uint8_t target_expansion;
-	uint8_t something_11[13];
-	uint8_t mbs_enabled;	// Main Bang Suppression enabled if 1
-};
-
-struct SRadarPresetFeedback {
-	uint32_t type;	// 0x010002
-	uint8_t something_1[213]; // 221 - magnetron current; 233, 234 - rotation time ms (251 total)
-	uint16_t magnetron_hours;
-	uint8_t something_2[6];
-	uint8_t magnetron_current;
-	uint8_t something_3[11];
-	uint16_t rotation_time;
-	uint8_t something_4[13];
-	uint8_t stc_preset_max;
-	uint8_t something_5[2];
-	uint8_t coarse_tune_arr[3];
-	uint8_t fine_tune_arr[3]; // 0, 1, 2 - fine tune value for SP, MP, LP
-	uint8_t something_6[6];	  
-	uint8_t display_timing_value;
-	uint8_t something_7[12];
-	uint8_t stc_preset_value;
-	uint8_t something_8[12];
-	uint8_t min_gain;
-	uint8_t max_gain;
-	uint8_t min_sea;
-	uint8_t max_sea;
-	uint8_t min_rain;
-	uint8_t max_rain;
-	uint8_t min_ftc;
-	uint8_t max_ftc;
-	uint8_t gain_value;
-	uint8_t sea_value;
-	uint8_t fine_tune_value;
-	uint8_t coarse_tune_value;
-	uint8_t signal_strength_value;
-	uint8_t something_9[2];
-};
-
-struct SCurveFeedback {
-	uint32_t type;	// 0x010005
-	uint8_t curve_value;
-};
-
-
-#pragma pack(pop)
-
 static uint8_t radar_signature_id[4] = { 1, 0, 0, 0 };
 static char *radar_signature = (char *)"Ethernet Dome";
-struct SRMRadarFunc {
-	uint32_t type;
-	uint32_t dev_id;
-	uint32_t func_id;	// 1
-	uint32_t something_1;
-	uint32_t something_2;
-	uint32_t mcast_ip;
-	uint32_t mcast_port;
-	uint32_t radar_ip;
-	uint32_t radar_port;
-};	
 
 bool CRMControl::ProcessReport(const UINT8 *report, int len)
 {
@@ -667,7 +793,7 @@ void CRMControl::ProcessFeedback(const UINT8 *data, int len)
 	if(len == sizeof(SRadarFeedback))
 	{
 		SRadarFeedback *fbPtr = (SRadarFeedback *)data;
-		if(fbPtr->type == 0x010001)
+		if(fbPtr->type == RM_MSG_FEEDBACK)
 		{
 			switch(fbPtr->status)
 			{
@@ -814,240 +940,137 @@ void CRMControl::ProcessCurveFeedback(const UINT8 *data, int len)
 	}
 }
 
-// Radar data
-
-struct CRMPacketHeader {
-    uint32_t type;		// 0x00010003
-    uint32_t zero_1;
-    uint32_t something_1;	// 0x0000001c
-    uint32_t nspokes;		// 0x00000008 - usually but changes
-    uint32_t spoke_count;	// 0x00000000 in regular, counting in HD
-    uint32_t zero_3;
-    uint32_t something_3;	// 0x00000001
-    uint32_t something_4;	// 0x00000000 or 0xffffffff in regular, 0x400 in HD
-};
-
-struct CRMRecordHeader {
-    uint32_t type;
-    uint32_t length;
-    // ...
-};
-
-struct CRMScanHeader {
-    uint32_t type;		// 0x00000001
-    uint32_t length;		// 0x00000028
-    uint32_t azimuth;
-    uint32_t something_2;	// 0x00000001 - 0x03 - HD
-    uint32_t something_3;	// 0x00000002
-    uint32_t something_4;	// 0x00000001 - 0x03 - HD
-    uint32_t something_5;	// 0x00000001 - 0x00 - HD
-    uint32_t something_6;	// 0x000001f4 - 0x00 - HD
-    uint32_t zero_1;
-    uint32_t something_7;	// 0x00000001
-};
-
-struct CRMOptHeader {		// No idea what is in there
-    uint32_t type;		// 0x00000002
-    uint32_t length;		// 0x0000001c
-    uint32_t zero_2[5];
-};
-
-struct CRMScanData {
-    uint32_t type;		// 0x00000003
-    uint32_t length;
-    uint32_t data_len;
-    // unsigned char data[rec_len - 8];
-};
+// Radar data, see RMProtocol.h for the layout
 
 void CRMControl::ProcessScanData(const UINT8 *data, int len)
 {
-	if(len > sizeof(CRMPacketHeader) + sizeof(CRMScanHeader))
+	CRMScanFrame frame(data, len);
+
+	if (!frame.IsValid())
 	{
-		CRMPacketHeader *pHeader = (CRMPacketHeader *)data;
-		if(pHeader->type != 0x00010003 || pHeader->something_1 != 0x0000001c || 
-			pHeader->something_3 != 0x0000001)
+		if (len >= (int)sizeof(CRMPacketHeader))
 		{
-			fprintf(stderr, "ProcessScanData::Packet header mismatch %x, %x, %x, %x.\n", pHeader->type, pHeader->something_1, 
-				pHeader->nspokes, pHeader->something_3);
-			return;
+			CRMPacketHeader pHeader;
+			memcpy(&pHeader, data, sizeof(pHeader));
+			fprintf(stderr, "ProcessScanData::Packet header mismatch %x, %x, %x, %x.\n", pHeader.type, pHeader.something_1,
+				pHeader.nspokes, pHeader.something_3);
 		}
+		return;
+	}
 
-		m_ri->m_state.Update(RADAR_TRANSMIT);
+	m_ri->m_state.Update(RADAR_TRANSMIT);
 
-		if(pHeader->something_4 == 0x400)
+	if(frame.IsHD())
+	{
+		if(m_ri->m_radar_type != RT_4G)
 		{
-			if(m_ri->m_radar_type != RT_4G)
-			{
-				m_ri->m_radar_type = RT_4G;
-				m_pi->m_pMessageBox->SetRadarType(RT_4G);
-			}
+			m_ri->m_radar_type = RT_4G;
+			m_pi->m_pMessageBox->SetRadarType(RT_4G);
 		}
-		else
+	}
+	else
+	{
+		if(m_ri->m_radar_type != RT_BR24)
 		{
-			if(m_ri->m_radar_type != RT_BR24)
-			{
-				m_ri->m_radar_type = RT_BR24;
-				m_pi->m_pMessageBox->SetRadarType(RT_BR24);
-			}
+			m_ri->m_radar_type = RT_BR24;
+			m_pi->m_pMessageBox->SetRadarType(RT_BR24);
 		}
-	
-		wxLongLong nowMillis = wxGetLocalTimeMillis();
-		int headerIdx = 0;
-		int nextOffset = sizeof(CRMPacketHeader);
+	}
 
+	// Heading is read once per packet, all spokes in it are drawn with the same one
+	m_pi->SetRadarHeading();
+	double hdt = m_pi->m_hdt + m_ri->m_viewpoint_rotation;
 
-		while(nextOffset < len)
-		{
-			CRMScanHeader *sHeader = (CRMScanHeader *)(data + nextOffset);
-			if(sHeader->type != 0x00000001 || sHeader->length != 0x00000028)
-			{
-				fprintf(stderr, "ProcessScanData::Scan header #%d (%d) - %x, %x.\n", headerIdx, nextOffset, sHeader->type, sHeader->length);
-				break;
-			}
-		
-			if(sHeader->something_2 != 0x00000001 || sHeader->something_3 != 0x00000002 || sHeader->something_4 != 0x00000001 ||
-    				sHeader->something_5 != 0x00000001 || sHeader->something_6 != 0x000001f4 || sHeader->something_7 != 0x00000001)
-			{
-				if(sHeader->something_2 != 3 || sHeader->something_3 != 2 || sHeader->something_4 != 3 ||
-					sHeader->something_5 != 0 || sHeader->something_6 != 0 || sHeader->something_7 != 1)
-				{
-					fprintf(stderr, "ProcessScanData::Scan header #%d part 2 check failed.\n", headerIdx);
-					break;
-				}
-				else if(m_ri->m_radar_type != RT_4G)
-				{
-					m_ri->m_radar_type = RT_4G;
-					m_pi->m_pMessageBox->SetRadarType(RT_4G);
-					fprintf(stderr, "ProcessScanData::Scan header #%d HD second header with regular first.\n", headerIdx);
-				}				
-				
-			}
-			else if(m_ri->m_radar_type != RT_BR24)
-			{
-				m_ri->m_radar_type = RT_BR24;
-				m_pi->m_pMessageBox->SetRadarType(RT_BR24);
-				fprintf(stderr, "ProcessScanData::Scan header #%d regular second header with HD first.\n", headerIdx);
-			}
+	RadarSpoke spokes[SPOKE_BATCH_MAX];
+	size_t nspokes = 0;
+	RadarGeometryType batch_geometry = GEOMETRY_STANDARD;
 
-			nextOffset += sizeof(CRMScanHeader);
+	SRMSpokeView view;
+	while(frame.Next(&view))
+	{
+		if(view.format == RM_SPOKE_HD && m_ri->m_radar_type != RT_4G)
+		{
+			m_ri->m_radar_type = RT_4G;
+			m_pi->m_pMessageBox->SetRadarType(RT_4G);
+			fprintf(stderr, "ProcessScanData::Scan header #%d HD second header with regular first.\n", frame.Index() - 1);
+		}
+		else if(view.format == RM_SPOKE_REGULAR && m_ri->m_radar_type != RT_BR24)
+		{
+			m_ri->m_radar_type = RT_BR24;
+			m_pi->m_pMessageBox->SetRadarType(RT_BR24);
+			fprintf(stderr, "ProcessScanData::Scan header #%d regular second header with HD first.\n", frame.Index() - 1);
+		}
 
-			CRMRecordHeader *nHeader = (CRMRecordHeader *)(data + nextOffset);
-			if(nHeader->type == 0x00000002)
-			{
-				if(nHeader->length != 0x0000001c)
-				{
-					// fprintf(stderr, "ProcessScanData::Opt header #%d part 2 check failed.\n", headerIdx);
-				}
-				nextOffset += nHeader->length;
-			}
+		// Regular spokes are 2048 x 512, HD ones are drawn at their native 2048 x 1024
+		RadarGeometryType geometry = view.format == RM_SPOKE_HD ? GEOMETRY_HD : GEOMETRY_STANDARD;
+		if(nspokes == SPOKE_BATCH_MAX || (nspokes && geometry != batch_geometry))
+		{
+			m_ri->ProcessRadarSpokes(batch_geometry, spokes, nspokes, m_range_meters);
+			nspokes = 0;
+		}
+		batch_geometry = geometry;
+		int lines = GeometryLines(geometry);
 
-			CRMScanData *pSData = (CRMScanData *)(data + nextOffset);
-			
-			if((pSData->type & 0x7fffffff) != 0x00000003 || pSData->length < pSData->data_len + 8)
-			{
-				fprintf(stderr, "ProcessScanData::Scan data header #%d check failed %x, %d, %d.\n", headerIdx, 
-					pSData->type, pSData->length, pSData->data_len);
-				break;
-			}
+		UINT8 *unpacked_data = m_spoke_data[nspokes];
+		const UINT8 *dataPtr;
+		if(view.format == RM_SPOKE_REGULAR)
+		{
+			size_t iS;
+			size_t iD = RMUnpackRLE(view.data, view.data_len, unpacked_data, RETURNS_PER_LINE, &iS);
 
-			UINT8 unpacked_data[1024], *dataPtr = 0;
-			if(m_ri->m_radar_type == RT_BR24)
+			// Bytes after data_len that are still in the record are used as unescaped samples
+			while(iS < view.record_len && iD < RETURNS_PER_LINE)
 			{
-				uint8_t *dData = (uint8_t *)unpacked_data;
-				uint8_t *sData = (uint8_t *)data + nextOffset + sizeof(CRMScanData);
-
-				int iS = 0;
-				int iD = 0;
-				while(iS < pSData->data_len)
-				{
-					if(*sData != 0x5c)
-					{
-						*dData++ = (((*sData) & 0x0f) << 4) + 0x0f;
-						*dData++ = ((*sData) & 0xf0) + 0x0f;
-						sData++;
-						iS++; iD += 2;
-					}
-					else
-					{					
-						uint8_t nFill = sData[1];
-						uint8_t cFill = sData[2];
-					
-						for(int i = 0; i < nFill; i++)
-						{
-							*dData++ = ((cFill & 0x0f) << 4) + 0x0f;
-							*dData++ = (cFill & 0xf0) + 0x0f;
-						}
-						sData += 3;
-						iS += 3;
-						iD += nFill * 2;
-					}
-	  
-				}
-				if(iD != 512)
-				{
-					while(iS < pSData->length - 8 && iD < 512)
-					{
-						*dData++ = ((*sData) & 0x0f) << 4;
-						*dData++ = (*sData) & 0xf0;
-						sData++;
-						iS++; iD += 2;
-					}
-				}
-				if(iD != 512)
-				{
-					// fprintf(stderr, "ProcessScanData::Packet %d line %d (%d/%x) not complete %d.\n", packetIdx, headerIdx,
-					// 	scan_idx, scan_idx, iD);
-				}
-				dataPtr = unpacked_data;
+				unpacked_data[iD++] = (view.data[iS] & 0x0f) << 4;
+				unpacked_data[iD++] = view.data[iS] & 0xf0;
+				iS++;
 			}
-			else if(m_ri->m_radar_type == RT_4G)
+			if(iD < RETURNS_PER_LINE)
 			{
-				if(pSData->data_len != RETURNS_PER_LINE * 2)
-				{
-					m_ri->m_statistics.broken_spokes++;
-					fprintf(stderr, "ProcessScanData data len %d should be %d.\n", pSData->data_len, RETURNS_PER_LINE);
-					break;
-				}
-				if(m_range_meters == 0) m_range_meters = 1852 / 4; // !!!TEMP delete!!!
-				dataPtr = (UINT8 *)data + nextOffset + sizeof(CRMScanData);
+				memset(unpacked_data + iD, 0, RETURNS_PER_LINE - iD);
 			}
-			else
+			dataPtr = unpacked_data;
+		}
+		else
+		{
+			if(view.data_len != GeometryHD::RETURNS)
 			{
-				fprintf(stderr, "ProcessScanData::Packet radar type is not set somehow.\n");
+				m_ri->m_statistics.broken_spokes++;
+				fprintf(stderr, "ProcessScanData data len %d should be %d.\n", (int)view.data_len, GeometryHD::RETURNS);
 				break;
 			}
+			if(m_range_meters == 0) m_range_meters = 1852 / 4; // !!!TEMP delete!!!
+			dataPtr = view.data;  // Straight from the receive buffer
+		}
 
-			nextOffset += pSData->length;
-			m_ri->m_statistics.spokes++;
-			unsigned int spoke = sHeader->azimuth;
-			if (m_next_spoke >= 0 && spoke != m_next_spoke) {
-				if (spoke > m_next_spoke) {
-					m_ri->m_statistics.missing_spokes += spoke - m_next_spoke;
-				} else {
-					m_ri->m_statistics.missing_spokes += SPOKES + spoke - m_next_spoke;
-				}
-			}
-			m_next_spoke = (spoke + 1) % 2048;
-
-			if((pSData->type & 0x80000000) != 0 && nextOffset < len)
-			{
-				// fprintf(stderr, "ProcessScanData::Last record %d (%d) in packet %d but still data to go %d:%d.\n",
-				// 	headerIdx, scan_idx, packetIdx, nextOffset, len); 
+		m_ri->m_statistics.spokes++;
+		m_total_spokes++;
+		int spoke = (int)(view.azimuth % lines);
+		if (m_next_spoke >= 0 && spoke != m_next_spoke) {
+			if (spoke > m_next_spoke) {
+				m_ri->m_statistics.missing_spokes += spoke - m_next_spoke;
+			} else {
+				m_ri->m_statistics.missing_spokes += lines + spoke - m_next_spoke;
 			}
-				
-			headerIdx++;
-			
-			m_pi->SetRadarHeading();
-			int hdt_raw = SCALE_DEGREES_TO_RAW(m_pi->m_hdt + m_ri->m_viewpoint_rotation);
-
-			int angle_raw = spoke * 2 + SCALE_DEGREES_TO_RAW(180);  // Compensate openGL rotation compared to North UP
-			int bearing_raw = angle_raw + hdt_raw;
+		}
+		m_next_spoke = (spoke + 1) % lines;
 
-			SpokeBearing a = MOD_ROTATION2048(angle_raw / 2);    // divide by 2 to map on 2048 scanlines
-			SpokeBearing b = MOD_ROTATION2048(bearing_raw / 2);  // divide by 2 to map on 2048 scanlines
+		int angle = spoke + lines / 2;  // Compensate openGL rotation compared to North UP
+		int bearing = angle + (int)(hdt * lines / DEGREES_PER_ROTATION);
 
-			m_ri->ProcessRadarSpoke(a, b, dataPtr, RETURNS_PER_LINE, m_range_meters);
-		}
+		RadarSpoke *s = &spokes[nspokes++];
+		s->angle = (angle + 2 * lines) % lines;
+		s->bearing = (bearing + 2 * lines) % lines;
+		s->data = (UINT8 *)dataPtr;
+		s->len = GeometryReturns(geometry);
+	}
+	if(nspokes)
+	{
+		m_ri->ProcessRadarSpokes(batch_geometry, spokes, nspokes, m_range_meters);
+	}
+	if(frame.Error())
+	{
+		fprintf(stderr, "ProcessScanData::%s in record #%d.\n", frame.Error(), frame.Index());
 	}
 }
 
@@ -1246,31 +1269,31 @@ static uint8_t rd_msg_curve_select[] = {
 void CRMControl::SetGain(uint8_t value)
 {
 	rd_msg_set_gain[20] = value;
-	sendto(m_dataSocket, rd_msg_set_gain, sizeof(rd_msg_set_gain), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+	SendCommand(rd_msg_set_gain, sizeof(rd_msg_set_gain));
 }
 
 void CRMControl::SetAutoGain(bool enable)
 {
 	rd_msg_set_gain_auto[16] = enable ? 1 : 0;
-	sendto(m_dataSocket, rd_msg_set_gain_auto, sizeof(rd_msg_set_gain_auto), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+	SendCommand(rd_msg_set_gain_auto, sizeof(rd_msg_set_gain_auto));
 }
 
 void CRMControl::SetTune(uint8_t value)
 {
 	rd_msg_tune_fine[16] = value;
-	sendto(m_dataSocket, rd_msg_tune_fine, sizeof(rd_msg_tune_fine), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+	SendCommand(rd_msg_tune_fine, sizeof(rd_msg_tune_fine));
 }
 
 void CRMControl::SetAutoTune(bool enable)
 {
 	rd_msg_tune_auto[12] = enable ? 1 : 0;
-	sendto(m_dataSocket, rd_msg_tune_auto, sizeof(rd_msg_tune_auto), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+	SendCommand(rd_msg_tune_auto, sizeof(rd_msg_tune_auto));
 }
 
 void CRMControl::SetCoarseTune(uint8_t value)
 {
 	rd_msg_tune_coarse[4] = value;
-	sendto(m_dataSocket, rd_msg_tune_coarse, sizeof(rd_msg_tune_coarse), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+	SendCommand(rd_msg_tune_coarse, sizeof(rd_msg_tune_coarse));
 }
 
 void CRMControl::EnableTX(bool enabled)
@@ -1278,7 +1301,7 @@ void CRMControl::EnableTX(bool enabled)
 	if(m_haveRadar && m_pi->m_settings.enable_transmit)
 	{
 		rd_msg_tx_control[4] = enabled ? 1 : 0;
-		sendto(m_dataSocket, rd_msg_tx_control, sizeof(rd_msg_tx_control), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+		SendCommand(rd_msg_tx_control, sizeof(rd_msg_tx_control));
 	}
 }
 
@@ -1287,62 +1310,62 @@ void CRMControl::TurnOff()
 	if(m_haveRadar && m_pi->m_settings.enable_transmit)
 	{
 		rd_msg_tx_control[4] = 3;
-		sendto(m_dataSocket, rd_msg_tx_control, sizeof(rd_msg_tx_control), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+		SendCommand(rd_msg_tx_control, sizeof(rd_msg_tx_control));
 	}
 }
 
 void CRMControl::SetRange(uint8_t range_idx)
 {
 	rd_msg_set_range[8] = range_idx;
-	sendto(m_dataSocket, rd_msg_set_range, sizeof(rd_msg_set_range), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+	SendCommand(rd_msg_set_range, sizeof(rd_msg_set_range));
 }
 
 void CRMControl::SetSTCPreset(uint8_t value)
 {
 	rd_msg_set_stc_preset[8] = value;
-	sendto(m_dataSocket, rd_msg_set_stc_preset, sizeof(rd_msg_set_stc_preset), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+	SendCommand(rd_msg_set_stc_preset, sizeof(rd_msg_set_stc_preset));
 }
 
 void CRMControl::SetFTC(uint8_t value)
 {
 	rd_msg_ftc_set[20] = value;
-	sendto(m_dataSocket, rd_msg_ftc_set, sizeof(rd_msg_ftc_set), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+	SendCommand(rd_msg_ftc_set, sizeof(rd_msg_ftc_set));
 }
 
 void CRMControl::SetFTCEnabled(bool enable)
 {
 	rd_msg_ftc_on[16] = enable ? 1 : 0;
-	sendto(m_dataSocket, rd_msg_ftc_on, sizeof(rd_msg_ftc_on), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+	SendCommand(rd_msg_ftc_on, sizeof(rd_msg_ftc_on));
 }
 
 void CRMControl::SetRain(uint8_t value)
 {
 	rd_msg_rain_set[20] = value;
-	sendto(m_dataSocket, rd_msg_rain_set, sizeof(rd_msg_rain_set), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+	SendCommand(rd_msg_rain_set, sizeof(rd_msg_rain_set));
 }
 
 void CRMControl::SetRainEnabled(bool enable)
 {
 	rd_msg_rain_on[16] = enable ? 1 : 0;
-	sendto(m_dataSocket, rd_msg_rain_on, sizeof(rd_msg_rain_on), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+	SendCommand(rd_msg_rain_on, sizeof(rd_msg_rain_on));
 }
 
 void CRMControl::SetSea(uint8_t value)
 {
 	rd_msg_set_sea[20] = value;
-	sendto(m_dataSocket, rd_msg_set_sea, sizeof(rd_msg_set_sea), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+	SendCommand(rd_msg_set_sea, sizeof(rd_msg_set_sea));
 }
 
 void CRMControl::SetAutoSea(uint8_t value)
 {
 	rd_msg_sea_auto[16] = value;
-	sendto(m_dataSocket, rd_msg_sea_auto, sizeof(rd_msg_sea_auto), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+	SendCommand(rd_msg_sea_auto, sizeof(rd_msg_sea_auto));
 }
 
 void CRMControl::SetDisplayTiming(uint8_t value)
 {
 	rd_msg_set_display_timing[8] = value;
-	sendto(m_dataSocket, rd_msg_set_display_timing, sizeof(rd_msg_set_display_timing), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+	SendCommand(rd_msg_set_display_timing, sizeof(rd_msg_set_display_timing));
 }
 
 void CRMControl::SetBearingOffset(int32_t value)
@@ -1351,19 +1374,19 @@ void CRMControl::SetBearingOffset(int32_t value)
 	rd_msg_bearing_offset[5] = (value >> 8) & 0xff;
 	rd_msg_bearing_offset[6] = (value >> 16) & 0xff;
 	rd_msg_bearing_offset[7] = (value >> 24) & 0xff;
-	sendto(m_dataSocket, rd_msg_bearing_offset, sizeof(rd_msg_bearing_offset), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+	SendCommand(rd_msg_bearing_offset, sizeof(rd_msg_bearing_offset));
 }
 
 void CRMControl::SetSeaClutterCurve(uint8_t id)
 {
 	rd_msg_curve_select[4] = curve_values[id - 1];
-	sendto(m_dataSocket, rd_msg_curve_select, sizeof(rd_msg_curve_select), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+	SendCommand(rd_msg_curve_select, sizeof(rd_msg_curve_select));
 }
 
 void CRMControl::EnableMBS(bool enable)
 {
 	rd_msg_mbs_control[16] = enable ? 1 : 0;
-	sendto(m_dataSocket, rd_msg_mbs_control, sizeof(rd_msg_mbs_control), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+	SendCommand(rd_msg_mbs_control, sizeof(rd_msg_mbs_control));
 }
 
 bool CRMControl::SetInterferenceRejection(uint8_t value)
@@ -1371,7 +1394,7 @@ bool CRMControl::SetInterferenceRejection(uint8_t value)
 	if(value >= 0 && value <= 2)
 	{
 		rd_msg_interference_rejection[4] = value;
-		sendto(m_dataSocket, rd_msg_interference_rejection, sizeof(rd_msg_interference_rejection), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+		SendCommand(rd_msg_interference_rejection, sizeof(rd_msg_interference_rejection));
 	}
 	else return false;
 }
@@ -1381,7 +1404,7 @@ bool CRMControl::SetTargetExpansion(uint8_t value)
 	if(value >= 0 && value <= 2)
 	{
 		rd_msg_target_expansion[8] = value;
-		sendto(m_dataSocket, rd_msg_target_expansion, sizeof(rd_msg_target_expansion), 0, (struct sockaddr*)&m_radar_addr, sizeof(m_radar_addr));
+		SendCommand(rd_msg_target_expansion, sizeof(rd_msg_target_expansion));
 	}
 	else return false;
 }
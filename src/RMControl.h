@@ -33,12 +33,24 @@
 #define _RM_CONTROL_H_
 
 #include <exception>
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
 #include "pi_common.h"
 #include "socketutil.h"
 #include "RadarInfo.h"
+#include "RMPacketRing.h"
+#include "RMReactor.h"
+#include "RMRecorder.h"
+#include "SpokePipeline.h"
 
 PLUGIN_BEGIN_NAMESPACE
 
+#define RECEIVE_BATCH_MAX (32)       // Most datagrams drained from the data socket per wakeup
+#define COMMAND_QUEUE_SIZE (16)      // Outgoing control messages waiting for the reactor
+#define COMMAND_MAX_SIZE (128)       // Largest control message
+
 struct value_not_set : public std::exception {
 	const char * what () const throw ()
 	{
@@ -58,7 +70,7 @@ class CValue {
 	bool m_set;
 	int m_value;
     public:
-	CValue(int value = 0, bool set = false) : m_value(value), m_set(set) { };
+	CValue(int value = 0, bool set = false) : m_set(set), m_value(value) { };
 	int Get() const { if(!m_set) throw value_not_set(); return m_value; }
 	bool IsSet() const { return m_set; }
 	void Set(int value) { m_value = value; m_set = true; }
@@ -91,16 +103,55 @@ struct SMiscRadarInfo {
 	int m_rotationPeriod;
 };
 
-class CRMControl : public wxThread {
+class CRMControl;
+
+/*
+ * Runs the decode and spoke pipeline for one radar. It consumes the raw frames that
+ * the I/O reactor (CRMControl::OnDataReadable) puts in the packet ring, so that a render
+ * stall holding the RadarInfo or draw locks no longer stops the socket being drained.
+ */
+class CRMProcessThread : public wxThread {
+    public:
+	CRMProcessThread(CRMControl *control);
+
+	void *Entry(void);
+	void Shutdown(void) { m_quit = true; }
+
+    private:
+	CRMControl *m_control;
+	volatile bool m_quit;
+};
+
+struct SCommand {
+	size_t len;
+	UINT8 data[COMMAND_MAX_SIZE];
+};
+
+/*
+ * Protocol handler for one radar. It has no thread of its own: the sockets are
+ * serviced by the shared CRMReactor, which calls the On...Readable() methods when
+ * there is data and Tick() once per REACTOR_TICK_MILLIS.
+ */
+class CRMControl {
+	friend class CRMProcessThread;
+	friend class CRMReactor;
+
 	SMiscRadarInfo m_miscInfo;
 
     public:
 	CRMControl(br24radar_pi *pi, RadarInfo *ri);
 	~CRMControl(void);
 
-	void *Entry(void);
-	void OnExit(void);
-	void Shutdown(void) { m_quit = true; }
+	// Called on the reactor thread
+	void Start(void);
+	void Stop(void);
+	void Tick(void);
+	void OnReportReadable(void);
+	void OnDataReadable(void);
+	void SendPendingCommands(void);
+
+	bool InjectFrame(const UINT8 *data, int len);
+	volatile long m_total_spokes;  // Spokes decoded since start, never reset
 
 	sockaddr_in *m_mcast_addr;
 	sockaddr_in m_radar_addr;
@@ -166,6 +217,10 @@ class CRMControl : public wxThread {
 	int m_next_spoke;     // emulator next spoke
 	int m_next_rotation;  // slowly rotate emulator
 
+	int ReceiveBatch(SOCKET socket, UINT8 **buffers, int count);
+	void SendCommand(const uint8_t *msg, size_t len);
+	void CloseSockets(void);
+
 	SOCKET PickNextEthernetCard();
 	SOCKET GetNewDataSocket();
 	// SOCKET GetNewCommandSocket();
@@ -175,11 +230,39 @@ class CRMControl : public wxThread {
 	RadarInfo *m_ri;  // All transfer of data passes back through this.
 	volatile bool m_quit;
 
+	int m_reactor_slot;  // Index assigned by CRMReactor::AddRadar
+	SOCKET m_reportSocket;
+	sockaddr_in m_mcast_found_addr;
+	int m_no_data_timeout;  // Ticks without data, sockets are reopened when this reaches 2
+	bool m_rx_seen;         // Something was received since the last Tick()
+
+	// Control messages are queued by the GUI thread and sent by the reactor thread,
+	// which is the only one that touches the sockets.
+	wxCriticalSection m_command_lock;
+	SCommand m_commands[COMMAND_QUEUE_SIZE];
+	int m_command_count;
+
 	struct ifaddrs *m_interface_array;
 	struct ifaddrs *m_interface;
 
 	char m_radar_status;
 
+	// Frames read from the data socket go straight into ring slots and are decoded
+	// by m_process_thread. When the ring is full they are read into the scratch
+	// arena instead and dropped, so the kernel buffer keeps being drained.
+	CRMPacketRing m_ring;
+	wxCriticalSection m_producer_lock;  // Serialises the socket and InjectFrame() producers
+	CRMProcessThread *m_process_thread;
+	wxSemaphore m_process_wakeup;
+	UINT8 m_rx_arena[RECEIVE_BATCH_MAX][RECEIVE_BUFFER_SIZE];
+	int m_rx_size[RECEIVE_BATCH_MAX];
+	sockaddr_in m_rx_from[RECEIVE_BATCH_MAX];
+#ifdef __linux__
+	struct mmsghdr m_rx_msgs[RECEIVE_BATCH_MAX];
+	struct iovec m_rx_iov[RECEIVE_BATCH_MAX];
+#endif
+	UINT8 m_spoke_data[SPOKE_BATCH_MAX][RETURNS_PER_LINE];  // Unpacked regular spokes, used by m_process_thread only
+
 	time_t m_lastKeepalive1s;
 	time_t m_lastKeepalive5s;
 
@@ -0,0 +1,119 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "RMFrameExport.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+CRMFrameExport::CRMFrameExport(br24radar_pi *pi, const wxString &dir)
+	: wxThread(wxTHREAD_JOINABLE)
+	, m_pi(pi)
+	, m_dir(dir)
+	, m_quit(false)
+{
+	Create(64 * 1024);
+}
+
+CRMFrameExport::~CRMFrameExport(void)
+{
+}
+
+bool CRMFrameExport::Write(int radar, const RadarFrame *frame)
+{
+	wxString name = wxString::Format(wxT("%s%cradar%c.pgm"), m_dir.c_str(), wxFileName::GetPathSeparator(), 'A' + radar);
+	wxString temp = name + wxT(".tmp");
+	FILE *f = fopen(temp.mb_str(), "wb");
+
+	if (!f)
+	{
+		return false;
+	}
+	fprintf(f, "P5\n# range %d m rotation %lu\n%d %d\n255\n", frame->range_meters, frame->rotation, frame->returns,
+	        frame->lines);
+	size_t size = (size_t)frame->lines * frame->returns;
+	bool ok = fwrite(frame->samples, 1, size, f) == size;
+	ok = fclose(f) == 0 && ok;
+	if (!ok || rename(temp.mb_str(), name.mb_str()) != 0)
+	{
+		remove(temp.mb_str());
+		return false;
+	}
+	return true;
+}
+
+void *CRMFrameExport::Entry(void)
+{
+	unsigned long written[RADARS];
+	bool failed = false;
+
+	for (int r = 0; r < RADARS; r++)
+	{
+		written[r] = (unsigned long)-1;
+		m_pi->m_radar[r]->AddFrameReader();
+	}
+	wxLogMessage(wxT("RMRadar_pi: Exporting radar frames to %s"), m_dir.c_str());
+
+	while (!m_quit)
+	{
+		for (int r = 0; r < RADARS; r++)
+		{
+			RadarFrame *frame = m_pi->m_radar[r]->GetFrame();
+
+			if (!frame)
+			{
+				continue;
+			}
+			if (frame->rotation != written[r])
+			{
+				if (Write(r, frame))
+				{
+					failed = false;
+				}
+				else if (!failed)
+				{
+					wxLogMessage(wxT("RMRadar_pi: Cannot write radar frames to %s"), m_dir.c_str());
+					failed = true;  // Once, not every rotation
+				}
+				written[r] = frame->rotation;
+			}
+			frame->Release();
+		}
+		wxMilliSleep(FRAME_EXPORT_POLL_MILLIS);
+	}
+
+	for (int r = 0; r < RADARS; r++)
+	{
+		m_pi->m_radar[r]->RemoveFrameReader();
+	}
+	return 0;
+}
+
+PLUGIN_END_NAMESPACE
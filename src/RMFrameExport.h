@@ -0,0 +1,71 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _RM_FRAME_EXPORT_H_
+#define _RM_FRAME_EXPORT_H_
+
+#include "br24radar_pi.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define FRAME_EXPORT_POLL_MILLIS (250)  // A rotation takes over a second, this sees every one
+
+class RadarFrame;
+
+/*
+ * Writes every rotation of each radar as a binary PGM image, radarA.pgm and radarB.pgm
+ * in the export directory. It is a RadarFrame reader: it holds the latest frame of a
+ * radar while it writes it, so the spoke pipeline is never stopped and nothing is copied.
+ *
+ * The image has one row per line, row 0 dead ahead and rows turning clockwise, and one
+ * column per return. A file is written next to the image and renamed over it, so other
+ * programs never see half of a rotation.
+ */
+class CRMFrameExport : public wxThread {
+    public:
+	CRMFrameExport(br24radar_pi *pi, const wxString &dir);
+	~CRMFrameExport(void);
+
+	void *Entry(void);
+	void Shutdown(void) { m_quit = true; }
+	const wxString &GetDir(void) const { return m_dir; }
+
+    private:
+	bool Write(int radar, const RadarFrame *frame);
+
+	br24radar_pi *m_pi;
+	wxString m_dir;
+	volatile bool m_quit;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RM_FRAME_EXPORT_H_ */
@@ -0,0 +1,84 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _RM_PACKET_RING_H_
+#define _RM_PACKET_RING_H_
+
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define RECEIVE_BUFFER_SIZE (2048)  // Largest datagram accepted
+#define PACKET_RING_SIZE (256)      // Raw frames buffered between receive and processing, must be a power of 2
+
+struct CRMPacket {
+	int len;
+	UINT8 data[RECEIVE_BUFFER_SIZE];
+};
+
+/*
+ * Bounded single producer / single consumer ring of raw frames.
+ *
+ * The receive thread is the only writer of m_head, the processing thread the
+ * only writer of m_tail. Each side publishes its index with a release store and
+ * reads the other side's index with an acquire load, so no lock is needed.
+ * The slots themselves are preallocated; the producer fills the slots returned by
+ * WriteSlot() and then makes them visible with Publish(), the consumer reads
+ * ReadSlot() and gives them back with Consume().
+ */
+class CRMPacketRing {
+    public:
+	CRMPacketRing() : m_head(0), m_tail(0) { }
+
+	// Producer side
+	size_t FreeSlots() const { return PACKET_RING_SIZE - (m_head - __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE)); }
+	CRMPacket *WriteSlot(size_t i) { return &m_slots[(m_head + i) & (PACKET_RING_SIZE - 1)]; }
+	size_t Publish(size_t n)
+	{
+		__atomic_store_n(&m_head, m_head + n, __ATOMIC_RELEASE);
+		return m_head - __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE);  // occupancy, for the high-water mark
+	}
+
+	// Consumer side
+	size_t Available() const { return __atomic_load_n(&m_head, __ATOMIC_ACQUIRE) - m_tail; }
+	CRMPacket *ReadSlot(size_t i) { return &m_slots[(m_tail + i) & (PACKET_RING_SIZE - 1)]; }
+	void Consume(size_t n) { __atomic_store_n(&m_tail, m_tail + n, __ATOMIC_RELEASE); }
+
+    private:
+	size_t m_head;  // written by producer only
+	char m_pad[64 - sizeof(size_t)];  // keep head and tail on separate cache lines
+	size_t m_tail;  // written by consumer only
+	CRMPacket m_slots[PACKET_RING_SIZE];
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RM_PACKET_RING_H_ */
@@ -0,0 +1,201 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _RM_PROTOCOL_H_
+#define _RM_PROTOCOL_H_
+
+#include <stdint.h>
+
+/*
+ * Wire layout of the Raymarine SeaTalk-HS radar messages, as far as it is known.
+ * This header deliberately has no wxWidgets or plugin dependencies so that the
+ * stand-alone simulator (sim/RMRadarSim.cpp) speaks exactly the same protocol.
+ * All fields are little endian, as the radar sends them.
+ */
+
+#define SEATALK_HS_ANNOUNCE_GROUP	"224.0.0.1"
+#define SEATALK_HS_ANNOUNCE_PORT	5800
+
+#define RM_MSG_FEEDBACK		(0x00010001)
+#define RM_MSG_PRESET_FEEDBACK	(0x00010002)
+#define RM_MSG_SCAN_DATA	(0x00010003)
+#define RM_MSG_CURVE_FEEDBACK	(0x00010005)
+
+//
+// The following is the received radar state. It sends this regularly
+// but especially after something sends it a state change.
+//
+#pragma pack(push, 1)
+
+struct SRadarFeedback {
+	uint32_t type;	// 0x010001
+	uint32_t range_values[11];
+	uint32_t something_1[33]; 
+	uint8_t status;		// 2 - warmup, 1 - transmit, 0 - standby, 6 - shutting down (warmup time - countdown), 3 - shutdown
+	uint8_t something_2[3];
+	uint8_t warmup_time;
+	uint8_t signal_strength;	// number of bars
+	uint8_t something_3[7];
+	uint8_t range_id;
+	uint8_t something_4[2];
+	uint8_t auto_gain;
+	uint8_t something_5[3];
+	uint32_t gain;
+	uint8_t auto_sea; // 0 - disabled; 1 - harbour, 2 - offshore, 3 - coastal 
+	uint8_t something_6[3];
+	uint8_t sea_value;
+	uint8_t rain_enabled;
+	uint8_t something_7[3];
+	uint8_t rain_value;
+	uint8_t ftc_enabled;
+	uint8_t something_8[3];
+	uint8_t ftc_value;
+	uint8_t auto_tune;
+	uint8_t something_9[3];
+	uint8_t tune;
+	int16_t bearing_offset;	// degrees * 10; left - negative, right - positive
+	uint8_t interference_rejection;
+	uint8_t something_10[3];
+	uint8_t target_expansion;
+	uint8_t something_11[13];
+	uint8_t mbs_enabled;	// Main Bang Suppression enabled if 1
+};
+
+struct SRadarPresetFeedback {
+	uint32_t type;	// 0x010002
+	uint8_t something_1[213]; // 221 - magnetron current; 233, 234 - rotation time ms (251 total)
+	uint16_t magnetron_hours;
+	uint8_t something_2[6];
+	uint8_t magnetron_current;
+	uint8_t something_3[11];
+	uint16_t rotation_time;
+	uint8_t something_4[13];
+	uint8_t stc_preset_max;
+	uint8_t something_5[2];
+	uint8_t coarse_tune_arr[3];
+	uint8_t fine_tune_arr[3]; // 0, 1, 2 - fine tune value for SP, MP, LP
+	uint8_t something_6[6];	  
+	uint8_t display_timing_value;
+	uint8_t something_7[12];
+	uint8_t stc_preset_value;
+	uint8_t something_8[12];
+	uint8_t min_gain;
+	uint8_t max_gain;
+	uint8_t min_sea;
+	uint8_t max_sea;
+	uint8_t min_rain;
+	uint8_t max_rain;
+	uint8_t min_ftc;
+	uint8_t max_ftc;
+	uint8_t gain_value;
+	uint8_t sea_value;
+	uint8_t fine_tune_value;
+	uint8_t coarse_tune_value;
+	uint8_t signal_strength_value;
+	uint8_t something_9[2];
+};
+
+struct SCurveFeedback {
+	uint32_t type;	// 0x010005
+	uint8_t curve_value;
+};
+
+
+#pragma pack(pop)
+
+// Announced on SEATALK_HS_ANNOUNCE_GROUP, tells where the radar sends its data
+// (mcast_ip:mcast_port) and where it listens for commands (radar_ip:radar_port).
+// The addresses are host order numbers, i.e. 0xE0000001 is 224.0.0.1.
+struct SRMRadarFunc {
+	uint32_t type;
+	uint32_t dev_id;
+	uint32_t func_id;	// 1
+	uint32_t something_1;
+	uint32_t something_2;
+	uint32_t mcast_ip;
+	uint32_t mcast_port;
+	uint32_t radar_ip;
+	uint32_t radar_port;
+};
+
+// A scan data message is a CRMPacketHeader followed by nspokes times
+// CRMScanHeader, an optional CRMOptHeader and CRMScanData + the returns.
+// The last CRMScanData of a message has bit 31 of its type set.
+// Regular radars send 4 bit samples run length encoded with 0x5c <count> <byte>,
+// HD radars send 1024 unencoded bytes.
+#pragma pack(push, 1)
+
+struct CRMPacketHeader {
+    uint32_t type;		// 0x00010003
+    uint32_t zero_1;
+    uint32_t something_1;	// 0x0000001c
+    uint32_t nspokes;		// 0x00000008 - usually but changes
+    uint32_t spoke_count;	// 0x00000000 in regular, counting in HD
+    uint32_t zero_3;
+    uint32_t something_3;	// 0x00000001
+    uint32_t something_4;	// 0x00000000 or 0xffffffff in regular, 0x400 in HD
+};
+
+struct CRMRecordHeader {
+    uint32_t type;
+    uint32_t length;
+    // ...
+};
+
+struct CRMScanHeader {
+    uint32_t type;		// 0x00000001
+    uint32_t length;		// 0x00000028
+    uint32_t azimuth;
+    uint32_t something_2;	// 0x00000001 - 0x03 - HD
+    uint32_t something_3;	// 0x00000002
+    uint32_t something_4;	// 0x00000001 - 0x03 - HD
+    uint32_t something_5;	// 0x00000001 - 0x00 - HD
+    uint32_t something_6;	// 0x000001f4 - 0x00 - HD
+    uint32_t zero_1;
+    uint32_t something_7;	// 0x00000001
+};
+
+struct CRMOptHeader {		// No idea what is in there
+    uint32_t type;		// 0x00000002
+    uint32_t length;		// 0x0000001c
+    uint32_t zero_2[5];
+};
+
+struct CRMScanData {
+    uint32_t type;		// 0x00000003
+    uint32_t length;
+    uint32_t data_len;
+    // unsigned char data[rec_len - 8];
+};
+
+#pragma pack(pop)
+
+#endif /* _RM_PROTOCOL_H_ */
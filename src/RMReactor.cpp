@@ -0,0 +1,339 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "RMReactor.h"
+#include "RMControl.h"
+#include <errno.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#else
+#include <fcntl.h>
+#endif
+
+PLUGIN_BEGIN_NAMESPACE
+
+CRMReactor::CRMReactor(br24radar_pi *pi)
+	: wxThread(wxTHREAD_JOINABLE)
+	, m_pi(pi)
+	, m_epoll(-1)
+	, m_wakeup_fd(-1)
+	, m_wakeup_post(-1)
+	, m_quit(false)
+{
+	Create(1024 * 1024);  // Stack size, be liberal
+
+	for (int r = 0; r < RADARS; r++)
+	{
+		m_radars[r] = 0;
+		m_started[r] = false;
+	}
+
+#ifdef __linux__
+	m_epoll = epoll_create1(EPOLL_CLOEXEC);
+	m_wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	m_wakeup_post = m_wakeup_fd;
+	if (m_epoll < 0 || m_wakeup_fd < 0)
+	{
+		perror("CRMReactor");
+		wxLogMessage(wxT("RMRadar_pi: Unable to create I/O reactor"));
+		m_epoll = -1;
+		return;
+	}
+
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u32 = WATCH_WAKEUP;
+	epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup_fd, &ev);
+#else
+	int fds[2];
+
+	if (pipe(fds) < 0)
+	{
+		perror("CRMReactor");
+		wxLogMessage(wxT("RMRadar_pi: Unable to create I/O reactor"));
+		m_poll_count = 0;
+		return;
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+		fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+	}
+	m_wakeup_fd = fds[0];
+	m_wakeup_post = fds[1];
+
+	m_poll[0].fd = m_wakeup_fd;
+	m_poll[0].events = POLLIN;
+	m_poll_tag[0] = WATCH_WAKEUP;
+	m_poll_count = 1;
+#endif
+}
+
+CRMReactor::~CRMReactor(void)
+{
+	if (m_wakeup_post != m_wakeup_fd && m_wakeup_post >= 0)
+	{
+		close(m_wakeup_post);
+	}
+	if (m_wakeup_fd >= 0)
+	{
+		close(m_wakeup_fd);
+	}
+	if (m_epoll >= 0)
+	{
+		close(m_epoll);
+	}
+}
+
+void CRMReactor::Wakeup(void)
+{
+	uint64_t one = 1;  // An eventfd takes exactly 8 bytes, a pipe anything
+
+	if (write(m_wakeup_post, &one, sizeof(one)) < 0 && errno != EAGAIN)
+	{
+		perror("CRMReactor::Wakeup");
+	}
+}
+
+void CRMReactor::Shutdown(void)
+{
+	m_quit = true;
+	Wakeup();
+}
+
+bool CRMReactor::AddRadar(CRMControl *control)
+{
+	{
+		wxCriticalSectionLocker lock(m_lock);
+
+		int r;
+		for (r = 0; r < RADARS && m_radars[r]; r++)
+		{
+		}
+		if (r == RADARS)
+		{
+			return false;
+		}
+		control->m_reactor_slot = r;
+		m_radars[r] = control;
+	}
+	Wakeup();
+	return true;
+}
+
+void CRMReactor::Watch(SOCKET socket, CRMControl *control, WatchKind kind)
+{
+	uint32_t tag = (control->m_reactor_slot << 2) | kind;
+
+#ifdef __linux__
+	struct epoll_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u32 = tag;
+	if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, socket, &ev) < 0)
+	{
+		perror("CRMReactor::Watch");
+	}
+#else
+	if (m_poll_count == REACTOR_MAX_WATCH)
+	{
+		wxLogMessage(wxT("RMRadar_pi: I/O reactor cannot watch more sockets"));
+		return;
+	}
+	m_poll[m_poll_count].fd = socket;
+	m_poll[m_poll_count].events = POLLIN;
+	m_poll[m_poll_count].revents = 0;
+	m_poll_tag[m_poll_count] = tag;
+	m_poll_count++;
+#endif
+}
+
+void CRMReactor::Unwatch(SOCKET socket)
+{
+#ifdef __linux__
+	struct epoll_event ev;  // Not used, but kernels before 2.6.9 require non-NULL
+
+	epoll_ctl(m_epoll, EPOLL_CTL_DEL, socket, &ev);
+#else
+	for (int i = 1; i < m_poll_count; i++)
+	{
+		if (m_poll[i].fd == socket)
+		{
+			m_poll_count--;
+			m_poll[i] = m_poll[m_poll_count];
+			m_poll_tag[i] = m_poll_tag[m_poll_count];
+			return;
+		}
+	}
+#endif
+}
+
+// Waits at most timeout milliseconds and returns the tags of the readable sockets,
+// or -1 when the wait itself failed.
+int CRMReactor::WaitReadable(uint32_t *tags, int timeout)
+{
+#ifdef __linux__
+	struct epoll_event events[REACTOR_MAX_EVENTS];
+	int n = epoll_wait(m_epoll, events, REACTOR_MAX_EVENTS, timeout);
+
+	for (int i = 0; i < n; i++)
+	{
+		tags[i] = events[i].data.u32;
+	}
+	return n;
+#else
+	int n = poll(m_poll, m_poll_count, timeout);
+
+	if (n <= 0)
+	{
+		return n;
+	}
+	// Collected first, a handler may Watch() or Unwatch() and reorder m_poll
+	n = 0;
+	for (int i = 0; i < m_poll_count && n < REACTOR_MAX_EVENTS; i++)
+	{
+		if (m_poll[i].revents & (POLLIN | POLLERR | POLLHUP))
+		{
+			tags[n++] = m_poll_tag[i];
+		}
+	}
+	return n;
+#endif
+}
+
+void CRMReactor::StartPendingRadars(void)
+{
+	wxCriticalSectionLocker lock(m_lock);
+
+	for (int r = 0; r < RADARS; r++)
+	{
+		if (m_radars[r] && !m_started[r])
+		{
+			m_radars[r]->Start();
+			m_started[r] = true;
+		}
+	}
+}
+
+void *CRMReactor::Entry(void)
+{
+	uint32_t tags[REACTOR_MAX_EVENTS];
+	// Wait 1s before the first tick so that other stuff is set up (fixes Windows core on startup)
+	wxLongLong next_tick = wxGetLocalTimeMillis() + REACTOR_TICK_MILLIS;
+
+	if (m_pi->m_settings.verbose)
+	{
+		wxLogMessage(wxT("RMRadar_pi: I/O reactor starting"));
+	}
+
+	while (!m_quit && m_wakeup_fd >= 0)
+	{
+		wxLongLong timeout = next_tick - wxGetLocalTimeMillis();
+		int n = WaitReadable(tags, MAX(timeout.ToLong(), 0));
+
+		if (m_quit)
+		{
+			break;
+		}
+		if (n < 0 && errno != EINTR)
+		{
+			perror("CRMReactor wait");
+			break;
+		}
+
+		for (int i = 0; i < n; i++)
+		{
+			uint32_t tag = tags[i];
+			int kind = tag & 3;
+
+			if (kind == WATCH_WAKEUP)
+			{
+				uint64_t count;
+				while (read(m_wakeup_fd, &count, sizeof(count)) > 0 && m_wakeup_post != m_wakeup_fd)
+				{
+					// Drain the pipe, one read resets an eventfd
+				}
+				StartPendingRadars();
+				for (int r = 0; r < RADARS; r++)
+				{
+					if (m_started[r])
+					{
+						m_radars[r]->SendPendingCommands();
+					}
+				}
+				continue;
+			}
+
+			CRMControl *control = m_radars[tag >> 2];
+			if (kind == WATCH_REPORT)
+			{
+				control->OnReportReadable();
+			}
+			else
+			{
+				control->OnDataReadable();
+			}
+		}
+
+		wxLongLong now = wxGetLocalTimeMillis();
+		if (now >= next_tick)
+		{
+			for (int r = 0; r < RADARS; r++)
+			{
+				if (m_started[r])
+				{
+					m_radars[r]->Tick();
+				}
+			}
+			next_tick = now + REACTOR_TICK_MILLIS;
+		}
+	}
+
+	for (int r = 0; r < RADARS; r++)
+	{
+		if (m_started[r])
+		{
+			m_radars[r]->Stop();
+			m_started[r] = false;
+		}
+	}
+
+	if (m_pi->m_settings.verbose)
+	{
+		wxLogMessage(wxT("RMRadar_pi: I/O reactor stopped"));
+	}
+	return 0;
+}
+
+PLUGIN_END_NAMESPACE
@@ -0,0 +1,97 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _RM_REACTOR_H_
+#define _RM_REACTOR_H_
+
+#include "br24radar_pi.h"
+#include "socketutil.h"
+#ifndef __linux__
+#include <poll.h>
+#endif
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define REACTOR_TICK_MILLIS (1000)  // Housekeeping (keepalives, socket timeouts) interval
+#define REACTOR_MAX_EVENTS (16)
+#define REACTOR_MAX_WATCH (1 + 2 * RADARS)  // Wakeup plus report and data socket per radar
+
+class CRMControl;
+
+/*
+ * One I/O thread for all radars. It owns an epoll set containing the report and
+ * data sockets of every CRMControl and dispatches readable sockets to the control
+ * that registered them. An eventfd wakes the thread immediately on shutdown, when
+ * a radar is added or when a control has queued outgoing commands.
+ * Other systems have neither, there a poll() array and a self pipe do the same job.
+ */
+class CRMReactor : public wxThread {
+    public:
+	enum WatchKind { WATCH_WAKEUP = 0, WATCH_REPORT = 1, WATCH_DATA = 2 };
+
+	CRMReactor(br24radar_pi *pi);
+	~CRMReactor(void);
+
+	void *Entry(void);
+
+	// Thread safe, callable from any thread
+	void Shutdown(void);
+	void Wakeup(void);
+	bool AddRadar(CRMControl *control);
+
+	// Reactor thread only
+	void Watch(SOCKET socket, CRMControl *control, WatchKind kind);
+	void Unwatch(SOCKET socket);
+
+    private:
+	void StartPendingRadars(void);
+	int WaitReadable(uint32_t *tags, int timeout);
+
+	br24radar_pi *m_pi;
+	int m_epoll;        // Only used on Linux
+	int m_wakeup_fd;    // eventfd, or the read end of the pipe
+	int m_wakeup_post;  // Same as m_wakeup_fd, or the write end of the pipe
+	volatile bool m_quit;
+
+#ifndef __linux__
+	struct pollfd m_poll[REACTOR_MAX_WATCH];
+	uint32_t m_poll_tag[REACTOR_MAX_WATCH];
+	int m_poll_count;
+#endif
+
+	wxCriticalSection m_lock;  // protects m_radars and m_started against AddRadar
+	CRMControl *m_radars[RADARS];
+	bool m_started[RADARS];
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RM_REACTOR_H_ */
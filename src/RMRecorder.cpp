@@ -0,0 +1,369 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "RMRecorder.h"
+#include <time.h>
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define PCAPNG_SHB_TYPE (0x0A0D0D0A)
+#define PCAPNG_IDB_TYPE (0x00000001)
+#define PCAPNG_EPB_TYPE (0x00000006)
+#define PCAPNG_BYTE_ORDER_MAGIC (0x1A2B3C4D)
+#define PCAPNG_LINKTYPE_IPV4 (228)
+#define PCAPNG_OPT_ENDOFOPT (0)
+#define PCAPNG_OPT_IF_NAME (2)
+#define PCAPNG_OPT_IF_TSRESOL (9)
+
+#define IPV4_HEADER_SIZE (20)
+#define UDP_HEADER_SIZE (8)
+#define EPB_OVERHEAD (32)  // Block header, interface, timestamp, lengths and trailing block length
+
+#define PAD4(x) (((x) + 3) & ~3)
+
+class CRMRecorderWriter : public wxThread {
+    public:
+	CRMRecorderWriter(CRMRecorder *recorder) : wxThread(wxTHREAD_JOINABLE), m_recorder(recorder) { Create(64 * 1024); }
+	void *Entry(void)
+	{
+		m_recorder->WriterLoop();
+		return 0;
+	}
+
+    private:
+	CRMRecorder *m_recorder;
+};
+
+static UINT8 *Put32(UINT8 *p, uint32_t v)
+{
+	memcpy(p, &v, sizeof(v));
+	return p + sizeof(v);
+}
+
+static UINT8 *Put16(UINT8 *p, uint16_t v)
+{
+	memcpy(p, &v, sizeof(v));
+	return p + sizeof(v);
+}
+
+CRMRecorder::CRMRecorder(br24radar_pi *pi)
+	: m_pi(pi)
+	, m_file(0)
+	, m_recording(false)
+	, m_stop(false)
+	, m_fill(0)
+	, m_pending(false)
+	, m_dropped(0)
+	, m_writer(0)
+{
+	m_arena[0] = m_arena[1] = 0;
+	m_used[0] = m_used[1] = 0;
+}
+
+CRMRecorder::~CRMRecorder(void)
+{
+	Stop();
+}
+
+uint64_t CRMRecorder::Timestamp(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Section header block followed by one interface description block per radar.
+ */
+void CRMRecorder::WriteHeader(void)
+{
+	UINT8 block[64];
+	UINT8 *p;
+
+	p = Put32(block, PCAPNG_SHB_TYPE);
+	p = Put32(p, 28);
+	p = Put32(p, PCAPNG_BYTE_ORDER_MAGIC);
+	p = Put16(p, 1);  // Major version
+	p = Put16(p, 0);  // Minor version
+	p = Put32(p, 0xffffffff);  // Section length unknown (64 bits)
+	p = Put32(p, 0xffffffff);
+	p = Put32(p, 28);
+	fwrite(block, 1, p - block, m_file);
+
+	for (int r = 0; r < RADARS; r++)
+	{
+		char name[8];
+		snprintf(name, sizeof(name), "Radar %c", 'A' + r);  // 7 characters, padded to 8
+
+		p = Put32(block, PCAPNG_IDB_TYPE);
+		p = Put32(p, 44);
+		p = Put16(p, PCAPNG_LINKTYPE_IPV4);
+		p = Put16(p, 0);
+		p = Put32(p, 0);  // No snap length limit
+		p = Put16(p, PCAPNG_OPT_IF_NAME);
+		p = Put16(p, 7);
+		memcpy(p, name, 8);
+		p += 8;
+		p = Put16(p, PCAPNG_OPT_IF_TSRESOL);
+		p = Put16(p, 1);
+		*p++ = 9;  // 10^-9 s
+		*p++ = 0;
+		*p++ = 0;
+		*p++ = 0;
+		p = Put16(p, PCAPNG_OPT_ENDOFOPT);
+		p = Put16(p, 0);
+		p = Put32(p, 44);
+		fwrite(block, 1, p - block, m_file);
+	}
+}
+
+bool CRMRecorder::Start(const wxString &filename)
+{
+	if (m_recording)
+	{
+		if (filename == m_filename)
+		{
+			return true;
+		}
+		Stop();
+	}
+
+	// Never overwrite a capture, it may be the one being replayed. When the file exists
+	// the recording goes to a new one with the time added to its name.
+	wxString path = filename;
+	if (wxFileExists(path))
+	{
+		wxFileName name(filename);
+		name.SetName(name.GetName() + wxDateTime::Now().Format(wxT("-%Y%m%d-%H%M%S")));
+		path = name.GetFullPath();
+	}
+	if (wxFileExists(path))
+	{
+		wxLogMessage(wxT("RMRadar_pi: Capture file %s already exists"), path.c_str());
+		return false;
+	}
+	m_file = fopen(path.mb_str(), "wb");
+	if (!m_file)
+	{
+		wxLogMessage(wxT("RMRadar_pi: Unable to open capture file %s"), path.c_str());
+		return false;
+	}
+	WriteHeader();
+
+	m_arena[0] = (UINT8 *)malloc(RECORDER_ARENA_SIZE);
+	m_arena[1] = (UINT8 *)malloc(RECORDER_ARENA_SIZE);
+	if (!m_arena[0] || !m_arena[1])
+	{
+		wxLogMessage(wxT("RMRadar_pi: Out of memory for capture buffers"));
+		Stop();
+		return false;
+	}
+	m_used[0] = m_used[1] = 0;
+	m_fill = 0;
+	m_pending = false;
+	m_dropped = 0;
+	m_stop = false;
+	m_filename = filename;
+	m_path = path;
+
+	m_writer = new CRMRecorderWriter(this);
+	if (m_writer->Run() != wxTHREAD_NO_ERROR)
+	{
+		delete m_writer;
+		m_writer = 0;
+		Stop();
+		return false;
+	}
+
+	{
+		wxCriticalSectionLocker lock(m_lock);
+		m_recording = true;
+	}
+	wxLogMessage(wxT("RMRadar_pi: Recording radar data to %s"), path.c_str());
+	return true;
+}
+
+void CRMRecorder::Stop(void)
+{
+	{
+		wxCriticalSectionLocker lock(m_lock);
+		m_recording = false;
+	}
+
+	if (m_writer)
+	{
+		m_stop = true;
+		m_wakeup.Post();
+		m_writer->Wait();
+		delete m_writer;
+		m_writer = 0;
+		wxLogMessage(wxT("RMRadar_pi: Recording to %s stopped, %d records dropped"), m_path.c_str(), m_dropped);
+	}
+	if (m_file)
+	{
+		fclose(m_file);
+		m_file = 0;
+	}
+	free(m_arena[0]);
+	free(m_arena[1]);
+	m_arena[0] = m_arena[1] = 0;
+	m_filename.Clear();
+	m_path.Clear();
+}
+
+void CRMRecorder::Record(int radar, const UINT8 *data, size_t len, const sockaddr_in *from, const sockaddr_in *to,
+                         uint64_t timestamp)
+{
+	if (!m_recording)
+	{
+		return;
+	}
+
+	size_t captured = IPV4_HEADER_SIZE + UDP_HEADER_SIZE + len;
+	size_t block_len = EPB_OVERHEAD + PAD4(captured);
+
+	wxCriticalSectionLocker lock(m_lock);
+
+	if (!m_recording)
+	{
+		return;
+	}
+	if (m_used[m_fill] + block_len > RECORDER_ARENA_SIZE)
+	{
+		if (m_pending || block_len > RECORDER_ARENA_SIZE)
+		{
+			m_dropped++;
+			return;
+		}
+		m_pending = true;
+		m_fill ^= 1;
+		m_wakeup.Post();
+	}
+
+	UINT8 *block = m_arena[m_fill] + m_used[m_fill];
+	UINT8 *p = block;
+
+	p = Put32(p, PCAPNG_EPB_TYPE);
+	p = Put32(p, (uint32_t)block_len);
+	p = Put32(p, (uint32_t)radar);
+	p = Put32(p, (uint32_t)(timestamp >> 32));
+	p = Put32(p, (uint32_t)timestamp);
+	p = Put32(p, (uint32_t)captured);
+	p = Put32(p, (uint32_t)captured);
+
+	// IPv4 header, all multi-byte fields in network order
+	UINT8 *ip = p;
+	uint16_t total = htons((uint16_t)captured);
+	memset(ip, 0, IPV4_HEADER_SIZE);
+	ip[0] = 0x45;  // Version 4, 5 words
+	memcpy(ip + 2, &total, 2);
+	ip[8] = 1;   // TTL
+	ip[9] = 17;  // UDP
+	memcpy(ip + 12, &from->sin_addr, 4);
+	memcpy(ip + 16, &to->sin_addr, 4);
+	uint32_t sum = 0;
+	for (int i = 0; i < IPV4_HEADER_SIZE; i += 2)
+	{
+		sum += (ip[i] << 8) | ip[i + 1];
+	}
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	ip[10] = (UINT8)(~sum >> 8);
+	ip[11] = (UINT8)~sum;
+	p += IPV4_HEADER_SIZE;
+
+	// UDP header, checksum 0 = not computed
+	uint16_t udp_len = htons((uint16_t)(UDP_HEADER_SIZE + len));
+	memcpy(p, &from->sin_port, 2);
+	memcpy(p + 2, &to->sin_port, 2);
+	memcpy(p + 4, &udp_len, 2);
+	p[6] = p[7] = 0;
+	p += UDP_HEADER_SIZE;
+
+	memcpy(p, data, len);
+	p += len;
+	while ((p - block) & 3)
+	{
+		*p++ = 0;
+	}
+	p = Put32(p, (uint32_t)block_len);
+
+	m_used[m_fill] += block_len;
+}
+
+void CRMRecorder::WriterLoop(void)
+{
+	for (;;)
+	{
+		bool stop = m_stop;
+		int write = -1;
+
+		if (!stop)
+		{
+			m_wakeup.WaitTimeout(RECORDER_FLUSH_MILLIS);
+		}
+
+		{
+			wxCriticalSectionLocker lock(m_lock);
+
+			if (!m_pending && m_used[m_fill] > 0)
+			{
+				// Nothing full yet, but write what we have so the file stays current
+				m_pending = true;
+				m_fill ^= 1;
+			}
+			if (m_pending)
+			{
+				write = m_fill ^ 1;
+			}
+		}
+
+		if (write >= 0)
+		{
+			if (fwrite(m_arena[write], 1, m_used[write], m_file) != m_used[write])
+			{
+				wxLogMessage(wxT("RMRadar_pi: Error writing capture file %s"), m_path.c_str());
+			}
+			fflush(m_file);
+
+			wxCriticalSectionLocker lock(m_lock);
+			m_used[write] = 0;
+			m_pending = false;
+		}
+		else if (stop)
+		{
+			break;
+		}
+	}
+}
+
+PLUGIN_END_NAMESPACE
@@ -0,0 +1,99 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _RM_RECORDER_H_
+#define _RM_RECORDER_H_
+
+#include "br24radar_pi.h"
+#include "socketutil.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define RECORDER_ARENA_SIZE (4 * 1024 * 1024)  // Size of each of the two write buffers
+#define RECORDER_FLUSH_MILLIS (250)             // Partially filled buffers are written at least this often
+
+class CRMRecorderWriter;
+
+/*
+ * Writes every datagram received from the radars to a pcapng file, so that
+ * what a radar sends in production can be replayed offline.
+ *
+ * Each radar is a separate pcapng interface (interface id = radar number) with
+ * nanosecond timestamp resolution. Datagrams are stored as LINKTYPE_IPV4 packets
+ * with a synthesised IPv4 + UDP header carrying the source and destination address.
+ *
+ * Record() is called on the reactor thread and only copies into the active half
+ * of a double buffered arena; a background CRMRecorderWriter thread writes the
+ * other half to disk. If the writer falls behind by a full arena the record is
+ * dropped rather than blocking the receive path.
+ */
+class CRMRecorder {
+	friend class CRMRecorderWriter;
+
+    public:
+	CRMRecorder(br24radar_pi *pi);
+	~CRMRecorder(void);
+
+	// GUI thread
+	bool Start(const wxString &filename);
+	void Stop(void);
+	bool IsRecording(void) const { return m_recording; }
+
+	// Reactor thread
+	void Record(int radar, const UINT8 *data, size_t len, const sockaddr_in *from, const sockaddr_in *to, uint64_t timestamp);
+
+	static uint64_t Timestamp(void);  // Nanoseconds since the epoch
+
+    private:
+	void WriteHeader(void);
+	void WriterLoop(void);
+
+	br24radar_pi *m_pi;
+	FILE *m_file;
+	wxString m_filename;  // As passed to Start()
+	wxString m_path;      // The file written, m_filename or a new name when that existed
+	volatile bool m_recording;
+	volatile bool m_stop;
+
+	wxCriticalSection m_lock;  // protects the arena bookkeeping below
+	UINT8 *m_arena[2];
+	size_t m_used[2];
+	int m_fill;         // Arena that Record() appends to
+	bool m_pending;     // The other arena is full and being written
+	int m_dropped;      // Records lost because both arenas were full
+
+	wxSemaphore m_wakeup;
+	CRMRecorderWriter *m_writer;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RM_RECORDER_H_ */
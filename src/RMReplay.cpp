@@ -0,0 +1,365 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "RMReplay.h"
+#include "RMControl.h"
+#include "RMProtocol.h"
+#include "SpokePipeline.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define PCAPNG_SHB_TYPE (0x0A0D0D0A)
+#define PCAPNG_IDB_TYPE (0x00000001)
+#define PCAPNG_EPB_TYPE (0x00000006)
+#define PCAPNG_BYTE_ORDER_MAGIC (0x1A2B3C4D)
+#define PCAPNG_OPT_IF_TSRESOL (9)
+
+#define LINKTYPE_ETHERNET (1)
+#define LINKTYPE_RAW (101)
+#define LINKTYPE_IPV4 (228)
+
+#define NANOS_PER_SECOND (1000000000ULL)
+
+static uint32_t Get32(const UINT8 *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static uint16_t Get16(const UINT8 *p)
+{
+	uint16_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+CRMReplay::CRMReplay(br24radar_pi *pi, const wxString &filename, int speed)
+	: wxThread(wxTHREAD_JOINABLE)
+	, m_packets_per_second(0.)
+	, m_spokes_per_second(0.)
+	, m_pi(pi)
+	, m_filename(filename)
+	, m_speed(speed)
+	, m_quit(false)
+	, m_fd(-1)
+	, m_map(0)
+	, m_map_size(0)
+	, m_interface_count(0)
+	, m_packets(0)
+	, m_spokes_start(0)
+	, m_rate_packets(0)
+	, m_rate_spokes(0)
+{
+	Create(64 * 1024);
+}
+
+CRMReplay::~CRMReplay(void)
+{
+	Unmap();
+}
+
+bool CRMReplay::Map(void)
+{
+	struct stat st;
+
+	m_fd = open(m_filename.mb_str(), O_RDONLY);
+	if (m_fd < 0 || fstat(m_fd, &st) < 0 || st.st_size == 0)
+	{
+		wxLogMessage(wxT("RMRadar_pi: Unable to open replay file %s"), m_filename.c_str());
+		Unmap();
+		return false;
+	}
+	m_map_size = st.st_size;
+	void *map = mmap(0, m_map_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+	if (map == MAP_FAILED)
+	{
+		wxLogMessage(wxT("RMRadar_pi: Unable to map replay file %s"), m_filename.c_str());
+		Unmap();
+		return false;
+	}
+	m_map = (const UINT8 *)map;
+	madvise(map, m_map_size, MADV_SEQUENTIAL);
+	return true;
+}
+
+void CRMReplay::Unmap(void)
+{
+	if (m_map)
+	{
+		munmap((void *)m_map, m_map_size);
+		m_map = 0;
+	}
+	if (m_fd >= 0)
+	{
+		close(m_fd);
+		m_fd = -1;
+	}
+}
+
+/*
+ * Find the UDP payload in a captured packet. Returns 0 for anything that is not
+ * a complete IPv4/UDP datagram.
+ */
+const UINT8 *CRMReplay::UdpPayload(const Interface &itf, const UINT8 *packet, size_t len, size_t *payload_len, int *dst_port)
+{
+	switch (itf.link_type)
+	{
+	case LINKTYPE_ETHERNET:
+		if (len < 14 || packet[12] != 0x08 || packet[13] != 0x00)
+		{
+			return 0;
+		}
+		packet += 14;
+		len -= 14;
+		break;
+	case LINKTYPE_RAW:
+	case LINKTYPE_IPV4:
+		break;
+	default:
+		return 0;
+	}
+
+	if (len < 20 || (packet[0] >> 4) != 4 || packet[9] != 17)
+	{
+		return 0;
+	}
+	size_t ip_header = (packet[0] & 0x0f) * 4;
+	if (len < ip_header + 8)
+	{
+		return 0;
+	}
+	const UINT8 *udp = packet + ip_header;
+	size_t udp_len = (udp[4] << 8) | udp[5];
+	if (udp_len < 8 || ip_header + udp_len > len)
+	{
+		return 0;
+	}
+	*dst_port = (udp[2] << 8) | udp[3];
+	*payload_len = udp_len - 8;
+	return udp + 8;
+}
+
+bool CRMReplay::Deliver(int radar, const UINT8 *data, size_t len)
+{
+	if (radar >= RADARS)
+	{
+		radar = 0;
+	}
+	CRMControl *control = m_pi->m_radar[radar]->m_radarControl;
+	if (!control)
+	{
+		return true;
+	}
+
+	// Never drop: wait for the processing thread instead, so that a replay at
+	// max speed measures the pipeline rather than the ring size.
+	while (!control->InjectFrame(data, (int)len))
+	{
+		if (m_quit)
+		{
+			return false;
+		}
+		wxMilliSleep(1);
+	}
+	m_packets++;
+	return true;
+}
+
+void CRMReplay::UpdateRates(wxLongLong now, bool final)
+{
+	long spokes = 0;
+
+	for (int r = 0; r < RADARS; r++)
+	{
+		if (m_pi->m_radar[r]->m_radarControl)
+		{
+			spokes += m_pi->m_radar[r]->m_radarControl->m_total_spokes;
+		}
+	}
+
+	if (final)
+	{
+		wxLongLong elapsed = now - m_start_time;
+		double seconds = elapsed.ToDouble() / 1000.;
+		spokes -= m_spokes_start;
+		if (seconds > 0.)
+		{
+			wxLogMessage(wxT("RMRadar_pi: Replay of %s done: %ld packets, %ld spokes in %.2f s = %.0f packets/s, %.0f spokes/s"),
+			             m_filename.c_str(), m_packets, spokes, seconds, m_packets / seconds, spokes / seconds);
+		}
+		return;
+	}
+
+	wxLongLong elapsed = now - m_rate_time;
+	double seconds = elapsed.ToDouble() / 1000.;
+	if (seconds >= 1.)
+	{
+		m_packets_per_second = (m_packets - m_rate_packets) / seconds;
+		m_spokes_per_second = (spokes - m_rate_spokes) / seconds;
+		m_rate_packets = m_packets;
+		m_rate_spokes = spokes;
+		m_rate_time = now;
+	}
+}
+
+void *CRMReplay::Entry(void)
+{
+	if (!Map())
+	{
+		return 0;
+	}
+
+	wxLogMessage(wxT("RMRadar_pi: Replaying %s at speed %d"), m_filename.c_str(), m_speed);
+
+	m_start_time = m_rate_time = wxGetLocalTimeMillis();
+	UpdateRates(m_start_time, false);
+	m_spokes_start = m_rate_spokes;
+
+	uint64_t first_capture = 0;
+	uint64_t first_wall = 0;
+	bool first = true;
+	size_t offset = 0;
+
+	while (!m_quit && offset + 12 <= m_map_size)
+	{
+		const UINT8 *block = m_map + offset;
+		uint32_t type = Get32(block);
+		uint32_t block_len = Get32(block + 4);
+
+		if (block_len < 12 || (block_len & 3) || offset + block_len > m_map_size)
+		{
+			wxLogMessage(wxT("RMRadar_pi: Replay file %s is truncated or corrupt at offset %lu"), m_filename.c_str(),
+			             (unsigned long)offset);
+			break;
+		}
+		offset += block_len;
+
+		if (type == PCAPNG_SHB_TYPE)
+		{
+			if (block_len < 28 || Get32(block + 8) != PCAPNG_BYTE_ORDER_MAGIC)
+			{
+				wxLogMessage(wxT("RMRadar_pi: Replay file %s has an unsupported byte order"), m_filename.c_str());
+				break;
+			}
+			m_interface_count = 0;  // Interface ids are per section
+		}
+		else if (type == PCAPNG_IDB_TYPE && block_len >= 20)
+		{
+			if (m_interface_count == REPLAY_MAX_INTERFACES)
+			{
+				continue;
+			}
+			Interface &itf = m_interfaces[m_interface_count++];
+			itf.link_type = Get16(block + 8);
+			itf.ticks_per_second = 1000000;  // Default resolution is microseconds
+
+			const UINT8 *opt = block + 16;
+			const UINT8 *end = block + block_len - 4;
+			while (opt + 4 <= end)
+			{
+				uint16_t code = Get16(opt);
+				uint16_t len = Get16(opt + 2);
+				if (code == 0 || opt + 4 + len > end)
+				{
+					break;
+				}
+				if (code == PCAPNG_OPT_IF_TSRESOL && len >= 1)
+				{
+					UINT8 v = opt[4];
+					uint64_t ticks = 1;
+					for (int i = 0; i < (v & 0x7f); i++)
+					{
+						ticks *= (v & 0x80) ? 2 : 10;
+					}
+					itf.ticks_per_second = ticks;
+				}
+				opt += 4 + ((len + 3) & ~3);
+			}
+		}
+		else if (type == PCAPNG_EPB_TYPE && block_len >= 32)
+		{
+			uint32_t interface_id = Get32(block + 8);
+			uint64_t ticks = ((uint64_t)Get32(block + 12) << 32) | Get32(block + 16);
+			size_t captured = Get32(block + 20);
+
+			if ((int)interface_id >= m_interface_count || 28 + captured > block_len - 4)
+			{
+				continue;
+			}
+
+			size_t len;
+			int port;
+			const Interface &itf = m_interfaces[interface_id];
+			const UINT8 *payload = UdpPayload(itf, block + 28, captured, &len, &port);
+			if (!payload || port == SEATALK_HS_ANNOUNCE_PORT)
+			{
+				continue;
+			}
+
+			if (m_speed > 0)
+			{
+				uint64_t capture = ticks / itf.ticks_per_second * NANOS_PER_SECOND +
+				                   ticks % itf.ticks_per_second * NANOS_PER_SECOND / itf.ticks_per_second;
+				if (first)
+				{
+					first_capture = capture;
+					first_wall = MonotonicNanos();
+					first = false;
+				}
+				// Timestamps that go backwards play at once rather than hours from now
+				uint64_t due = first_wall + (capture > first_capture ? capture - first_capture : 0) / m_speed;
+				for (uint64_t now = MonotonicNanos(); now < due && !m_quit; now = MonotonicNanos())
+				{
+					wxMilliSleep((unsigned long)wxMin((due - now) / 1000000 + 1, (uint64_t)100));
+				}
+			}
+
+			if (!Deliver(interface_id, payload, len))
+			{
+				break;
+			}
+			UpdateRates(wxGetLocalTimeMillis(), false);
+		}
+	}
+
+	UpdateRates(wxGetLocalTimeMillis(), true);
+	m_packets_per_second = 0.;
+	m_spokes_per_second = 0.;
+	Unmap();
+	return 0;
+}
+
+PLUGIN_END_NAMESPACE
@@ -0,0 +1,102 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _RM_REPLAY_H_
+#define _RM_REPLAY_H_
+
+#include "br24radar_pi.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define REPLAY_MAX_INTERFACES (8)
+
+/*
+ * Plays back a pcapng capture, as written by CRMRecorder or by Wireshark,
+ * through the normal CRMControl packet ring, so that ProcessFrame/ProcessScanData
+ * and everything downstream run exactly as they do for a live radar.
+ *
+ * The file is memory mapped. Captured datagrams on pcapng interface r are sent to
+ * radar r (interfaces beyond the last radar go to the first one). Announcements
+ * on the SeaTalk-HS report port are skipped, the sockets are closed while a
+ * replay is active.
+ *
+ * speed 1 plays in real time, N plays N times faster and 0 plays as fast as the
+ * processing thread can consume, never dropping frames.
+ */
+class CRMReplay : public wxThread {
+    public:
+	CRMReplay(br24radar_pi *pi, const wxString &filename, int speed);
+	~CRMReplay(void);
+
+	void *Entry(void);
+	void Shutdown(void) { m_quit = true; }
+	const wxString &GetFilename(void) const { return m_filename; }
+	int GetSpeed(void) const { return m_speed; }
+
+	// Rates over the last second, for the statistics box
+	double m_packets_per_second;
+	double m_spokes_per_second;
+
+    private:
+	struct Interface {
+		int link_type;
+		uint64_t ticks_per_second;
+	};
+
+	bool Map(void);
+	void Unmap(void);
+	const UINT8 *UdpPayload(const Interface &itf, const UINT8 *packet, size_t len, size_t *payload_len, int *dst_port);
+	bool Deliver(int radar, const UINT8 *data, size_t len);
+	void UpdateRates(wxLongLong now, bool final);
+
+	br24radar_pi *m_pi;
+	wxString m_filename;
+	int m_speed;
+	volatile bool m_quit;
+
+	int m_fd;
+	const UINT8 *m_map;
+	size_t m_map_size;
+
+	Interface m_interfaces[REPLAY_MAX_INTERFACES];
+	int m_interface_count;
+
+	long m_packets;
+	long m_spokes_start;
+	long m_rate_packets;
+	long m_rate_spokes;
+	wxLongLong m_rate_time;
+	wxLongLong m_start_time;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RM_REPLAY_H_ */
@@ -0,0 +1,144 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "RMScanFrame.h"
+#include <string.h>
+
+#define RM_HD_PACKET_MARKER (0x400)
+#define RM_RECORD_LAST (0x80000000)
+
+
+CRMScanFrame::CRMScanFrame(const uint8_t *data, size_t len)
+	: m_data(data)
+	, m_len(len)
+	, m_offset(sizeof(CRMPacketHeader))
+	, m_index(0)
+	, m_valid(false)
+	, m_hd(false)
+	, m_error(0)
+{
+	if (len <= sizeof(CRMPacketHeader) + sizeof(CRMScanHeader))
+	{
+		Fail("Packet too short");
+		return;
+	}
+
+	const CRMPacketHeader *header = (const CRMPacketHeader *)data;
+	if (header->type != RM_MSG_SCAN_DATA || header->something_1 != 0x1c || header->something_3 != 1)
+	{
+		Fail("Packet header mismatch");
+		return;
+	}
+	m_valid = true;
+	m_hd = header->something_4 == RM_HD_PACKET_MARKER;
+}
+
+bool CRMScanFrame::Fail(const char *error)
+{
+	m_error = error;
+	m_offset = m_len;
+	return false;
+}
+
+bool CRMScanFrame::Next(SRMSpokeView *spoke)
+{
+	if (m_offset >= m_len)
+	{
+		return false;
+	}
+
+	// Headers are copied out so that the checks below see exactly what is used afterwards
+	CRMScanHeader scan;
+	if (m_len - m_offset < sizeof(scan))
+	{
+		return Fail("Scan header truncated");
+	}
+	memcpy(&scan, m_data + m_offset, sizeof(scan));
+	if (scan.type != 1 || scan.length != sizeof(CRMScanHeader))
+	{
+		return Fail("Scan header mismatch");
+	}
+	if (scan.something_2 == 1 && scan.something_3 == 2 && scan.something_4 == 1 && scan.something_5 == 1 &&
+		scan.something_6 == 0x1f4 && scan.something_7 == 1)
+	{
+		spoke->format = RM_SPOKE_REGULAR;
+	}
+	else if (scan.something_2 == 3 && scan.something_3 == 2 && scan.something_4 == 3 && scan.something_5 == 0 &&
+		scan.something_6 == 0 && scan.something_7 == 1)
+	{
+		spoke->format = RM_SPOKE_HD;
+	}
+	else
+	{
+		return Fail("Scan header part 2 check failed");
+	}
+	spoke->azimuth = scan.azimuth;
+	m_offset += sizeof(CRMScanHeader);
+
+	// Optional record that we know nothing about
+	CRMRecordHeader record;
+	if (m_len - m_offset >= sizeof(record))
+	{
+		memcpy(&record, m_data + m_offset, sizeof(record));
+		if (record.type == 2)
+		{
+			if (record.length < sizeof(record) || record.length > m_len - m_offset)
+			{
+				return Fail("Optional header length invalid");
+			}
+			m_offset += record.length;
+		}
+	}
+
+	CRMScanData data;
+	if (m_len - m_offset < sizeof(data))
+	{
+		return Fail("Scan data header truncated");
+	}
+	memcpy(&data, m_data + m_offset, sizeof(data));
+	uint32_t length = data.length;
+	uint32_t data_len = data.data_len;
+	size_t available = m_len - m_offset - sizeof(data);
+	if ((data.type & ~RM_RECORD_LAST) != 3 || length < data_len + 8 || data_len > available)
+	{
+		return Fail("Scan data header check failed");
+	}
+
+	spoke->data = m_data + m_offset + sizeof(CRMScanData);
+	spoke->data_len = data_len;
+	// length counts from the length field, see the trailing bytes handling in ProcessScanData
+	spoke->record_len = length - 8 < available ? length - 8 : available;
+	spoke->last = (data.type & RM_RECORD_LAST) != 0;
+
+	m_offset = length < m_len - m_offset ? m_offset + length : m_len;
+	m_index++;
+	return true;
+}
@@ -0,0 +1,87 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _RM_SCAN_FRAME_H_
+#define _RM_SCAN_FRAME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "RMProtocol.h"
+
+enum RMSpokeFormat {
+	RM_SPOKE_REGULAR,	// 4 bit samples, run length encoded, see RMUnpackRLE()
+	RM_SPOKE_HD		// One byte per sample
+};
+
+// One spoke in a scan data message; the pointers refer to the receive buffer
+struct SRMSpokeView {
+	uint32_t azimuth;
+	RMSpokeFormat format;
+	const uint8_t *data;	// Encoded (regular) or raw (HD) samples
+	size_t data_len;	// CRMScanData.data_len
+	size_t record_len;	// Bytes after the CRMScanData header that are still part of the record and the message
+	bool last;		// Flagged as the last spoke of the message
+};
+
+/*
+ * Walks the spokes in a RM_MSG_SCAN_DATA message without copying. Every record
+ * header is checked against the message length once, so nothing that Next()
+ * returns points outside data[0 .. len-1], however malformed the message.
+ *
+ *	CRMScanFrame frame(data, len);
+ *	SRMSpokeView spoke;
+ *	while (frame.Next(&spoke)) { ... }
+ *	if (frame.Error()) { ... frame.Error() describes what was wrong ... }
+ */
+class CRMScanFrame {
+    public:
+	CRMScanFrame(const uint8_t *data, size_t len);
+
+	bool IsValid(void) const { return m_valid; }	// Packet header is a scan data header
+	bool IsHD(void) const { return m_hd; }		// Packet header says HD
+	int Index(void) const { return m_index; }	// Number of spokes returned so far
+	const char *Error(void) const { return m_error; }
+
+	bool Next(SRMSpokeView *spoke);
+
+    private:
+	bool Fail(const char *error);
+
+	const uint8_t *m_data;
+	size_t m_len;
+	size_t m_offset;
+	int m_index;
+	bool m_valid;
+	bool m_hd;
+	const char *m_error;
+};
+
+#endif /* _RM_SCAN_FRAME_H_ */
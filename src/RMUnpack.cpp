@@ -0,0 +1,382 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "RMUnpack.h"
+#include <string.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define RM_UNPACK_X86
+#include <immintrin.h>
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define RM_UNPACK_NEON
+#include <arm_neon.h>
+#endif
+
+#define RLE_ESCAPE (0x5c)
+#define RLE_ESCAPE_LEN (3)
+
+// Both samples of every possible byte, in memory order
+static uint8_t expand_table[256][2];
+
+static void InitExpandTable(void)
+{
+	for (int b = 0; b < 256; b++)
+	{
+		expand_table[b][0] = ((b & 0x0f) << 4) | 0x0f;
+		expand_table[b][1] = (b & 0xf0) | 0x0f;
+	}
+}
+
+/*
+ * Handle the escape at src[*is]: fill up to count sample pairs, as far as dst
+ * allows. Returns false when the escape is cut off at the end of src.
+ */
+static inline bool ExpandRun(const uint8_t *src, size_t src_len, size_t *is, uint8_t *dst, size_t dst_len, size_t *id)
+{
+	if (*is + RLE_ESCAPE_LEN > src_len)
+	{
+		return false;
+	}
+	size_t n = 2 * (size_t)src[*is + 1];
+	const uint8_t *pair = expand_table[src[*is + 2]];
+
+	if (n > dst_len - *id)
+	{
+		n = (dst_len - *id) & ~(size_t)1;
+	}
+	uint8_t *d = dst + *id;
+	for (size_t i = 0; i < n; i += 2)
+	{
+		d[i] = pair[0];
+		d[i + 1] = pair[1];
+	}
+	*id += n;
+	*is += RLE_ESCAPE_LEN;
+	return true;
+}
+
+/*
+ * Scalar remainder shared by all kernels: handles whatever is left once there
+ * are fewer than a vector's worth of bytes in src or dst.
+ */
+static size_t UnpackScalarFrom(const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len, size_t is, size_t id,
+	size_t *consumed)
+{
+	while (is < src_len && id + 2 <= dst_len)
+	{
+		if (src[is] != RLE_ESCAPE)
+		{
+			dst[id] = expand_table[src[is]][0];
+			dst[id + 1] = expand_table[src[is]][1];
+			is++;
+			id += 2;
+		}
+		else if (!ExpandRun(src, src_len, &is, dst, dst_len, &id))
+		{
+			is = src_len;  // Cut off escape, it counts as used
+		}
+	}
+	*consumed = is;
+	return id;
+}
+
+static size_t UnpackScalar(const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len, size_t *consumed)
+{
+	return UnpackScalarFrom(src, src_len, dst, dst_len, 0, 0, consumed);
+}
+
+#ifdef RM_UNPACK_X86
+
+static inline unsigned CountTrailingZeros(unsigned mask)
+{
+	return __builtin_ctz(mask);
+}
+
+/*
+ * 16 source bytes at a time: a compare finds the escapes, everything before the
+ * first one is expanded with nibble masks and an unpack (interleave), runs are
+ * filled 16 pairs per store.
+ */
+__attribute__((target("sse2")))
+static size_t UnpackSSE2(const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len, size_t *consumed)
+{
+	const __m128i escape = _mm_set1_epi8(RLE_ESCAPE);
+	const __m128i low = _mm_set1_epi8(0x0f);
+	const __m128i high = _mm_set1_epi8((char)0xf0);
+	size_t is = 0;
+	size_t id = 0;
+
+	while (is + 16 <= src_len && id + 32 <= dst_len)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + is));
+		unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, escape));
+		// Nibbles are at most 0x0f so the 16 bit shift cannot carry into the next byte
+		__m128i first = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, low), 4), low);
+		__m128i second = _mm_or_si128(_mm_and_si128(v, high), low);
+		_mm_storeu_si128((__m128i *)(dst + id), _mm_unpacklo_epi8(first, second));
+		_mm_storeu_si128((__m128i *)(dst + id + 16), _mm_unpackhi_epi8(first, second));
+
+		unsigned plain = mask ? CountTrailingZeros(mask) : 16;
+		is += plain;
+		id += 2 * plain;
+		if (plain < 16)
+		{
+			if (is + RLE_ESCAPE_LEN > src_len)
+			{
+				break;
+			}
+			size_t n = 2 * (size_t)src[is + 1];
+			if (n > dst_len - id)
+			{
+				break;  // Let the scalar code clamp it
+			}
+			const uint8_t *pair = expand_table[src[is + 2]];
+			__m128i fill = _mm_set1_epi16((short)(pair[0] | (pair[1] << 8)));
+			uint8_t *d = dst + id;
+			size_t i = 0;
+			for (; i + 16 <= n; i += 16)
+			{
+				_mm_storeu_si128((__m128i *)(d + i), fill);
+			}
+			for (; i < n; i += 2)
+			{
+				d[i] = pair[0];
+				d[i + 1] = pair[1];
+			}
+			id += n;
+			is += RLE_ESCAPE_LEN;
+		}
+	}
+	return UnpackScalarFrom(src, src_len, dst, dst_len, is, id, consumed);
+}
+
+/*
+ * As UnpackSSE2 with 32 source bytes. The unpacks work per 128 bit lane, so the
+ * halves are put back in order with a lane permute.
+ */
+__attribute__((target("avx2")))
+static size_t UnpackAVX2(const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len, size_t *consumed)
+{
+	const __m256i escape = _mm256_set1_epi8(RLE_ESCAPE);
+	const __m256i low = _mm256_set1_epi8(0x0f);
+	const __m256i high = _mm256_set1_epi8((char)0xf0);
+	size_t is = 0;
+	size_t id = 0;
+
+	while (is + 32 <= src_len && id + 64 <= dst_len)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i *)(src + is));
+		unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, escape));
+		__m256i first = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(v, low), 4), low);
+		__m256i second = _mm256_or_si256(_mm256_and_si256(v, high), low);
+		__m256i lo = _mm256_unpacklo_epi8(first, second);
+		__m256i hi = _mm256_unpackhi_epi8(first, second);
+		_mm256_storeu_si256((__m256i *)(dst + id), _mm256_permute2x128_si256(lo, hi, 0x20));
+		_mm256_storeu_si256((__m256i *)(dst + id + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+
+		unsigned plain = mask ? CountTrailingZeros(mask) : 32;
+		is += plain;
+		id += 2 * plain;
+		if (plain < 32)
+		{
+			if (is + RLE_ESCAPE_LEN > src_len)
+			{
+				break;
+			}
+			size_t n = 2 * (size_t)src[is + 1];
+			if (n > dst_len - id)
+			{
+				break;
+			}
+			const uint8_t *pair = expand_table[src[is + 2]];
+			__m256i fill = _mm256_set1_epi16((short)(pair[0] | (pair[1] << 8)));
+			uint8_t *d = dst + id;
+			size_t i = 0;
+			for (; i + 32 <= n; i += 32)
+			{
+				_mm256_storeu_si256((__m256i *)(d + i), fill);
+			}
+			for (; i < n; i += 2)
+			{
+				d[i] = pair[0];
+				d[i + 1] = pair[1];
+			}
+			id += n;
+			is += RLE_ESCAPE_LEN;
+		}
+	}
+	// GCC does not always add this for target("avx2") functions; without it every SSE
+	// instruction in the caller pays for the dirty upper halves of the ymm registers.
+	_mm256_zeroupper();
+	return UnpackScalarFrom(src, src_len, dst, dst_len, is, id, consumed);
+}
+
+#endif /* RM_UNPACK_X86 */
+
+#ifdef RM_UNPACK_NEON
+
+/*
+ * 16 source bytes at a time; vst2q interleaves the two sample planes for free.
+ * NEON has no movemask, so the first escape is located with a scalar scan, but
+ * only when the vector compare says there is one.
+ */
+static size_t UnpackNEON(const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len, size_t *consumed)
+{
+	const uint8x16_t escape = vdupq_n_u8(RLE_ESCAPE);
+	const uint8x16_t low = vdupq_n_u8(0x0f);
+	const uint8x16_t high = vdupq_n_u8(0xf0);
+	size_t is = 0;
+	size_t id = 0;
+
+	while (is + 16 <= src_len && id + 32 <= dst_len)
+	{
+		uint8x16_t v = vld1q_u8(src + is);
+		uint8x16_t eq = vceqq_u8(v, escape);
+		uint8x8_t any = vorr_u8(vget_low_u8(eq), vget_high_u8(eq));
+		uint8x16x2_t out;
+		out.val[0] = vorrq_u8(vshlq_n_u8(vandq_u8(v, low), 4), low);
+		out.val[1] = vorrq_u8(vandq_u8(v, high), low);
+		vst2q_u8(dst + id, out);
+
+		unsigned plain = 16;
+		if (vget_lane_u64(vreinterpret_u64_u8(any), 0))
+		{
+			plain = 0;
+			while (src[is + plain] != RLE_ESCAPE)
+			{
+				plain++;
+			}
+		}
+		is += plain;
+		id += 2 * plain;
+		if (plain < 16)
+		{
+			if (is + RLE_ESCAPE_LEN > src_len)
+			{
+				break;
+			}
+			size_t n = 2 * (size_t)src[is + 1];
+			if (n > dst_len - id)
+			{
+				break;
+			}
+			const uint8_t *pair = expand_table[src[is + 2]];
+			uint8x16_t fill = vreinterpretq_u8_u16(vdupq_n_u16(pair[0] | (pair[1] << 8)));
+			uint8_t *d = dst + id;
+			size_t i = 0;
+			for (; i + 16 <= n; i += 16)
+			{
+				vst1q_u8(d + i, fill);
+			}
+			for (; i < n; i += 2)
+			{
+				d[i] = pair[0];
+				d[i + 1] = pair[1];
+			}
+			id += n;
+			is += RLE_ESCAPE_LEN;
+		}
+	}
+	return UnpackScalarFrom(src, src_len, dst, dst_len, is, id, consumed);
+}
+
+#endif /* RM_UNPACK_NEON */
+
+#define RM_UNPACK_KERNELS_MAX (4)
+
+static RMUnpackKernel unpack_kernel = 0;
+static RMUnpackKernelInfo unpack_kernels[RM_UNPACK_KERNELS_MAX];
+static size_t unpack_kernel_count = 0;
+
+static void AddKernel(size_t *count, const char *name, RMUnpackKernel unpack)
+{
+	unpack_kernels[*count].name = name;
+	unpack_kernels[*count].unpack = unpack;
+	(*count)++;
+}
+
+// Fills unpack_kernels, fastest first, with every kernel that the CPU supports
+static void SelectKernel(void)
+{
+	size_t count = 0;
+
+	InitExpandTable();
+#ifdef RM_UNPACK_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+	{
+		AddKernel(&count, "AVX2", UnpackAVX2);
+	}
+	if (__builtin_cpu_supports("sse2"))
+	{
+		AddKernel(&count, "SSE2", UnpackSSE2);
+	}
+#endif
+#ifdef RM_UNPACK_NEON
+	AddKernel(&count, "NEON", UnpackNEON);
+#endif
+	AddKernel(&count, "scalar", UnpackScalar);
+	unpack_kernel_count = count;
+	// Several radar threads may get here at once; they all store the same values
+	__atomic_store_n(&unpack_kernel, unpack_kernels[0].unpack, __ATOMIC_RELEASE);
+}
+
+size_t RMUnpackRLE(const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len, size_t *consumed)
+{
+	RMUnpackKernel kernel = __atomic_load_n(&unpack_kernel, __ATOMIC_ACQUIRE);
+
+	if (!kernel)
+	{
+		SelectKernel();
+		kernel = unpack_kernel;
+	}
+	return kernel(src, src_len, dst, dst_len, consumed);
+}
+
+const char *RMUnpackKernelName(void)
+{
+	if (!__atomic_load_n(&unpack_kernel, __ATOMIC_ACQUIRE))
+	{
+		SelectKernel();
+	}
+	return unpack_kernels[0].name;
+}
+
+const RMUnpackKernelInfo *RMUnpackKernels(size_t *count)
+{
+	if (!__atomic_load_n(&unpack_kernel, __ATOMIC_ACQUIRE))
+	{
+		SelectKernel();
+	}
+	*count = unpack_kernel_count;
+	return unpack_kernels;
+}
@@ -0,0 +1,70 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _RM_UNPACK_H_
+#define _RM_UNPACK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Expansion of the run length encoded 4 bit samples in regular (non HD) scan
+ * data, see RMProtocol.h. Every byte holds two samples, low nibble first, that
+ * are expanded to (nibble << 4) | 0x0f; 0x5c <count> <byte> repeats <byte>
+ * count times.
+ *
+ * Unpacks src_len bytes from src into at most dst_len samples in dst and
+ * returns the number of samples produced. *consumed is set to the number of
+ * source bytes used, which is less than src_len only when dst filled up. An
+ * escape sequence that is cut off by the end of src produces nothing but counts
+ * as used. Output never goes beyond dst_len, but anything between the returned
+ * count and dst_len may have been overwritten.
+ *
+ * SSE2, AVX2 or NEON is used when the CPU has it, this is decided on the first
+ * call.
+ */
+size_t RMUnpackRLE(const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len, size_t *consumed);
+
+// Name of the implementation RMUnpackRLE uses, for the log
+const char *RMUnpackKernelName(void);
+
+typedef size_t (*RMUnpackKernel)(const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len, size_t *consumed);
+
+struct RMUnpackKernelInfo {
+	const char *name;
+	RMUnpackKernel unpack;
+};
+
+// Every implementation that this CPU can run, the one RMUnpackRLE uses first, so that
+// tests and benchmarks can compare them. Sets *count.
+const RMUnpackKernelInfo *RMUnpackKernels(size_t *count);
+
+#endif /* _RM_UNPACK_H_ */
@@ -36,12 +36,18 @@
 PLUGIN_BEGIN_NAMESPACE
 
 // Factory to generate a particular draw implementation
-RadarDraw* RadarDraw::make_Draw(RadarInfo* ri, int draw_method) {
+RadarDraw* RadarDraw::make_Draw(RadarInfo* ri, int draw_method, RadarGeometryType geometry) {
   switch (draw_method) {
     case 0:
-      return new RadarDrawVertex(ri);
+      if (geometry == GEOMETRY_HD) {
+        return new RadarDrawVertex<GeometryHD>(ri);
+      }
+      return new RadarDrawVertex<GeometryStandard>(ri);
     case 1:
-      return new RadarDrawShader(ri);
+      if (geometry == GEOMETRY_HD) {
+        return new RadarDrawShader<GeometryHD>(ri);
+      }
+      return new RadarDrawShader<GeometryStandard>(ri);
     default:
       wxLogError(wxT("BR24radar_pi: unsupported draw method %d"), draw_method);
   }
@@ -38,11 +38,20 @@ PLUGIN_BEGIN_NAMESPACE
 
 class RadarDraw {
  public:
-  static RadarDraw* make_Draw(RadarInfo* ri, int draw_method);
+  static RadarDraw* make_Draw(RadarInfo* ri, int draw_method, RadarGeometryType geometry);
 
   virtual bool Init() = 0;
-  virtual void DrawRadarImage() = 0;
-  virtual void ProcessRadarSpoke(int transparency, SpokeBearing angle, UINT8* data, size_t len) = 0;
+  // Draws the lines relative to the boat, or turned by the heading each line was received
+  // with (north_up), so the orientation can change without losing the image.
+  virtual void DrawRadarImage(bool north_up) = 0;
+  // Store a batch of spokes at their angle, with bearing - angle as their heading, taking the lock once.
+  // Only their spans are drawn, so these must have been encoded.
+  virtual void ProcessRadarSpokes(int transparency, const RadarSpoke* spokes, size_t count) = 0;
+  // Forget all lines received so far. Each line keeps the generation it was drawn in,
+  // so this only starts a new generation and lines from older ones are not drawn.
+  virtual void ResetSpokes() = 0;
+  // Like ProcessRadarSpokes, but only for lines not received since the last reset
+  virtual void ProcessPlaceholderSpokes(int transparency, const RadarSpoke* spokes, size_t count) = 0;
 
   virtual ~RadarDraw() = 0;
 
@@ -58,18 +58,29 @@ static const char *FragmentShaderText =
     "} \n";
 #endif
 
+// The lines are stored relative to the boat. For north up the line shown at bearing a is
+// the one at a - its heading; the heading of the last line is used to find that line,
+// as headings of neighbouring lines hardly differ.
 static const char *FragmentShaderColorText =
     "uniform sampler2D tex2d; \n"
+    "uniform sampler1D headings; \n"
+    "uniform float heading; \n"
+    "uniform float north_up; \n"
     "void main() \n"
     "{ \n"
     "   float d = length(gl_TexCoord[0].xy);\n"
     "   if (d >= 1.0) \n"
     "      discard; \n"
     "   float a = atan(gl_TexCoord[0].y, gl_TexCoord[0].x) / 6.28318; \n"
+    "   if (north_up > 0.5) { \n"
+    "      vec4 h = texture1D(headings, fract(a - heading)); \n"
+    "      a -= (h.x * 65280.0 + h.w * 255.0) / 65536.0; \n"
+    "   } \n"
     "   gl_FragColor = texture2D(tex2d, vec2(d, a)); \n"
     "} \n";
 
-bool RadarDrawShader::Init() {
+template <class G>
+bool RadarDrawShader<G>::Init() {
   m_format = GL_RGBA;
   m_channels = SHADER_COLOR_CHANNELS;
 
@@ -98,8 +109,8 @@ bool RadarDrawShader::Init() {
   glTexImage2D(/* target          = */ GL_TEXTURE_2D,
                /* level           = */ 0,
                /* internal_format = */ m_format,
-               /* width           = */ RETURNS_PER_LINE,
-               /* heigth          = */ LINES_PER_ROTATION,
+               /* width           = */ G::RETURNS,
+               /* heigth          = */ G::LINES,
                /* border          = */ 0,
                /* format          = */ m_format,
                /* type            = */ GL_UNSIGNED_BYTE,
@@ -107,13 +118,27 @@ bool RadarDrawShader::Init() {
   glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
+  // The heading of each line, on texture unit 1. Not filtered, as it is two bytes of one value.
+  if (!m_heading_texture) {
+    glGenTextures(1, &m_heading_texture);
+  }
+  ActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_1D, m_heading_texture);
+  glTexImage1D(GL_TEXTURE_1D, 0, GL_LUMINANCE8_ALPHA8, G::LINES, 0, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, m_heading_texels);
+  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  ActiveTexture(GL_TEXTURE0);
+  m_headings_changed = false;
+
   m_start_line = -1;
   m_end_line = 0;
 
   return true;
 }
 
-RadarDrawShader::~RadarDrawShader() {
+template <class G>
+RadarDrawShader<G>::~RadarDrawShader() {
   wxCriticalSectionLocker lock(m_exclusive);
 
   if (m_vertex) {
@@ -132,12 +157,17 @@ RadarDrawShader::~RadarDrawShader() {
     glDeleteTextures(1, &m_texture);
     m_texture = 0;
   }
+  if (m_heading_texture) {
+    glDeleteTextures(1, &m_heading_texture);
+    m_heading_texture = 0;
+  }
 }
 
-void RadarDrawShader::DrawRadarImage() {
+template <class G>
+void RadarDrawShader<G>::DrawRadarImage(bool north_up) {
   wxCriticalSectionLocker lock(m_exclusive);
 
-  if (!m_program || !m_texture) {
+  if (!m_program || !m_texture || !m_heading_texture) {
     return;
   }
 
@@ -145,6 +175,21 @@ void RadarDrawShader::DrawRadarImage() {
 
   UseProgram(m_program);
 
+  GLfloat heading = (GLfloat)m_last_heading / G::LINES;
+  GLfloat rotate = north_up ? 1.0f : 0.0f;
+  Uniform1i(GetUniformLocation(m_program, "tex2d"), 0);
+  Uniform1i(GetUniformLocation(m_program, "headings"), 1);
+  Uniform1fv(GetUniformLocation(m_program, "heading"), 1, &heading);
+  Uniform1fv(GetUniformLocation(m_program, "north_up"), 1, &rotate);
+
+  ActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_1D, m_heading_texture);
+  if (m_headings_changed) {
+    glTexSubImage1D(GL_TEXTURE_1D, 0, 0, G::LINES, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, m_heading_texels);
+    m_headings_changed = false;
+  }
+  ActiveTexture(GL_TEXTURE0);
+
   glBindTexture(GL_TEXTURE_2D, m_texture);
 
   if (m_start_line > -1) {
@@ -158,83 +203,184 @@ void RadarDrawShader::DrawRadarImage() {
                       /* level =    */ 0,
                       /* x-offset = */ 0,
                       /* y-offset = */ 0,
-                      /* width =    */ RETURNS_PER_LINE,
+                      /* width =    */ G::RETURNS,
                       /* height =   */ m_end_line,
                       /* format =   */ m_format,
                       /* type =     */ GL_UNSIGNED_BYTE,
                       /* pixels =   */ m_data);
-      // And then remap [m_start_line, LINES_PER_ROTATION>
+      // And then remap [m_start_line, G::LINES>
       glTexSubImage2D(/* target =   */ GL_TEXTURE_2D,
                       /* level =    */ 0,
                       /* x-offset = */ 0,
                       /* y-offset = */ m_start_line,
-                      /* width =    */ RETURNS_PER_LINE,
-                      /* height =   */ LINES_PER_ROTATION - m_start_line,
+                      /* width =    */ G::RETURNS,
+                      /* height =   */ G::LINES - m_start_line,
                       /* format =   */ m_format,
                       /* type =     */ GL_UNSIGNED_BYTE,
-                      /* pixels =   */ m_data + m_start_line * RETURNS_PER_LINE * m_channels);
+                      /* pixels =   */ m_data + m_start_line * G::RETURNS * m_channels);
     } else {
       // Remap [m_start_line, m_end_line>
       glTexSubImage2D(/* target =   */ GL_TEXTURE_2D,
                       /* level =    */ 0,
                       /* x-offset = */ 0,
                       /* y-offset = */ m_start_line,
-                      /* width =    */ RETURNS_PER_LINE,
+                      /* width =    */ G::RETURNS,
                       /* height =   */ m_end_line - m_start_line,
                       /* format =   */ m_format,
                       /* type =     */ GL_UNSIGNED_BYTE,
-                      /* pixels =   */ m_data + m_start_line * RETURNS_PER_LINE * m_channels);
+                      /* pixels =   */ m_data + m_start_line * G::RETURNS * m_channels);
     }
     m_start_line = -1;
     m_end_line = 0;
   }
 
-  // We tell the GPU to draw a square from (-512,-512) to (+512,+512).
-  // The shader morphs this into a circle.
-  float fullscale = 512;
-  glBegin(GL_QUADS);
-  glTexCoord2f(-1, -1);
-  glVertex2f(-fullscale, -fullscale);
-  glTexCoord2f(1, -1);
-  glVertex2f(fullscale, -fullscale);
-  glTexCoord2f(1, 1);
-  glVertex2f(fullscale, fullscale);
-  glTexCoord2f(-1, 1);
-  glVertex2f(-fullscale, fullscale);
-  glEnd();
+  if (m_current_lines == G::LINES) {
+    // We tell the GPU to draw a square from (-G::RETURNS,-G::RETURNS) to (+G::RETURNS,+G::RETURNS).
+    // The shader morphs this into a circle.
+    float fullscale = G::RETURNS;
+    glBegin(GL_QUADS);
+    glTexCoord2f(-1, -1);
+    glVertex2f(-fullscale, -fullscale);
+    glTexCoord2f(1, -1);
+    glVertex2f(fullscale, -fullscale);
+    glTexCoord2f(1, 1);
+    glVertex2f(fullscale, fullscale);
+    glTexCoord2f(-1, 1);
+    glVertex2f(-fullscale, fullscale);
+    glEnd();
+  } else {
+    // Since the last reset only part of the lines have been received; the texture still
+    // holds the old ones, so only the sectors of current lines are drawn.
+    for (int begin = 0; begin < G::LINES;) {
+      if (m_line_generation[begin] != m_generation) {
+        begin++;
+        continue;
+      }
+      int end = begin + 1;
+      while (end < G::LINES && m_line_generation[end] == m_generation) {
+        end++;
+      }
+      DrawSector(begin, end, north_up);
+      begin = end;
+    }
+  }
 
   UseProgram(0);
   glPopAttrib();
 }
 
-void RadarDrawShader::ProcessRadarSpoke(int transparency, SpokeBearing angle, UINT8 *data, size_t len) {
+#define SECTOR_RADIUS (1.1)           // Outer vertices of a sector, in texture coordinates
+#define SECTOR_STEP (G::LINES / 32)  // Lines per outer edge, short enough to stay outside the circle
+
+// Draws lines [begin, end> as a triangle fan around the centre, turned by their heading
+// for north up. The texture coordinates are the same as those of the square, the shader
+// discards what lies beyond the circle.
+// Caller holds m_exclusive
+template <class G>
+void RadarDrawShader<G>::DrawSector(int begin, int end, bool north_up) {
+  float fullscale = G::RETURNS;
+
+  glBegin(GL_TRIANGLE_FAN);
+  glTexCoord2f(0, 0);
+  glVertex2f(0, 0);
+  for (int line = begin;; line += SECTOR_STEP) {
+    if (line > end) {
+      line = end;
+    }
+    int turn = north_up ? m_line_heading[line < end ? line : end - 1] : 0;
+    double angle = (line + turn) * 2 * PI / G::LINES;
+    float x = (float)(SECTOR_RADIUS * cos(angle));
+    float y = (float)(SECTOR_RADIUS * sin(angle));
+    glTexCoord2f(x, y);
+    glVertex2f(x * fullscale, y * fullscale);
+    if (line == end) {
+      break;
+    }
+  }
+  glEnd();
+}
+
+template <class G>
+void RadarDrawShader<G>::ResetSpokes() {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  m_generation++;
+  m_current_lines = 0;
+}
+
+template <class G>
+void RadarDrawShader<G>::ProcessRadarSpokes(int transparency, const RadarSpoke *spokes, size_t count) {
+  GLubyte alpha = 255 * (MAX_OVERLAY_TRANSPARENCY - transparency) / MAX_OVERLAY_TRANSPARENCY;
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  for (size_t s = 0; s < count; s++) {
+    ProcessSpoke(alpha, spokes[s].angle, G::Mod(spokes[s].bearing - spokes[s].angle), spokes[s].spans, spokes[s].span_count);
+  }
+}
+
+template <class G>
+void RadarDrawShader<G>::ProcessPlaceholderSpokes(int transparency, const RadarSpoke *spokes, size_t count) {
   GLubyte alpha = 255 * (MAX_OVERLAY_TRANSPARENCY - transparency) / MAX_OVERLAY_TRANSPARENCY;
   wxCriticalSectionLocker lock(m_exclusive);
 
+  for (size_t s = 0; s < count; s++) {
+    SpokeBearing angle = spokes[s].angle;
+    if (angle >= 0 && angle < G::LINES && m_line_generation[angle] != m_generation) {
+      ProcessSpoke(alpha, angle, G::Mod(spokes[s].bearing - angle), spokes[s].spans, spokes[s].span_count);
+    }
+  }
+}
+
+// Caller holds m_exclusive
+template <class G>
+void RadarDrawShader<G>::ProcessSpoke(GLubyte alpha, SpokeBearing angle, SpokeBearing heading, const SpokeSpan *spans,
+                                      size_t span_count) {
   if (m_start_line == -1) {
     m_start_line = angle;  // Note that this only runs once after each draw,
   }
   m_end_line = angle + 1;  // whereas this keeps running every draw operation
 
-  if (m_channels == SHADER_COLOR_CHANNELS) {
-    unsigned char *d = m_data + (angle * RETURNS_PER_LINE) * m_channels;
-    for (size_t r = 0; r < len; r++) {
-      GLubyte strength = data[r];
-      BlobColour colour = m_ri->m_colour_map[strength];
-      d[0] = m_ri->m_colour_map_rgb[colour].Red();
-      d[1] = m_ri->m_colour_map_rgb[colour].Green();
-      d[2] = m_ri->m_colour_map_rgb[colour].Blue();
-      d[3] = colour != BLOB_NONE ? alpha : 0;
-      d += m_channels;
-    }
-  } else {
-    unsigned char *d = m_data + (angle * RETURNS_PER_LINE);
-    for (size_t r = 0; r < len; r++) {
-      GLubyte strength = data[r];
-      BlobColour colour = m_ri->m_colour_map[strength];
-      *d++ = (m_ri->m_colour_map_rgb[colour].Red() * alpha) >> 8;
+  if (m_line_heading[angle] != heading) {
+    UINT16 fraction = (UINT16)(heading * (65536 / G::LINES));
+    m_line_heading[angle] = heading;
+    m_heading_texels[angle][0] = (GLubyte)(fraction >> 8);
+    m_heading_texels[angle][1] = (GLubyte)(fraction & 0xff);
+    m_headings_changed = true;
+  }
+  m_last_heading = heading;
+
+  if (m_line_generation[angle] != m_generation) {
+    m_line_generation[angle] = m_generation;
+    m_current_lines++;
+  }
+
+  // The line is cleared and only the spans are written, the rest has no colour
+  unsigned char *line = m_data + (angle * G::RETURNS) * m_channels;
+  memset(line, 0, G::RETURNS * m_channels);
+
+  for (size_t i = 0; i < span_count; i++) {
+    size_t end = wxMin((size_t)spans[i].end, (size_t)G::RETURNS);
+    wxColour colour = m_ri->m_colour_map_rgb[spans[i].colour];
+    GLubyte red = colour.Red();
+    GLubyte green = colour.Green();
+    GLubyte blue = colour.Blue();
+
+    if (m_channels == SHADER_COLOR_CHANNELS) {
+      unsigned char *d = line + spans[i].start * m_channels;
+      for (size_t r = spans[i].start; r < end; r++) {
+        d[0] = red;
+        d[1] = green;
+        d[2] = blue;
+        d[3] = alpha;
+        d += m_channels;
+      }
+    } else if (spans[i].start < end) {
+      memset(line + spans[i].start, (red * alpha) >> 8, end - spans[i].start);
     }
   }
 }
 
+template class RadarDrawShader<GeometryStandard>;
+template class RadarDrawShader<GeometryHD>;
+
 PLUGIN_END_NAMESPACE
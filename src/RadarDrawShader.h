@@ -38,39 +38,61 @@ PLUGIN_BEGIN_NAMESPACE
 
 #define SHADER_COLOR_CHANNELS (4)  // RGB + Alpha
 
+template <class G>
 class RadarDrawShader : public RadarDraw {
  public:
   RadarDrawShader(RadarInfo* ri) {
     m_ri = ri;
-    m_start_line = LINES_PER_ROTATION;
+    m_start_line = G::LINES;
     m_end_line = 0;
     m_texture = 0;
+    m_heading_texture = 0;
     m_fragment = 0;
     m_vertex = 0;
     m_program = 0;
     m_format = GL_RGBA;
     m_channels = SHADER_COLOR_CHANNELS;
     memset(m_data, 0, sizeof(m_data));
+    memset(m_line_generation, 0, sizeof(m_line_generation));
+    memset(m_line_heading, 0, sizeof(m_line_heading));
+    memset(m_heading_texels, 0, sizeof(m_heading_texels));
+    m_last_heading = 0;
+    m_headings_changed = false;
+    m_generation = 1;
+    m_current_lines = 0;
   }
 
   ~RadarDrawShader();
 
   bool Init();
-  void DrawRadarImage();
-  void ProcessRadarSpoke(int transparency, SpokeBearing angle, UINT8* data, size_t len);
+  void DrawRadarImage(bool north_up);
+  void ProcessRadarSpokes(int transparency, const RadarSpoke* spokes, size_t count);
+  void ResetSpokes();
+  void ProcessPlaceholderSpokes(int transparency, const RadarSpoke* spokes, size_t count);
 
  private:
   RadarInfo* m_ri;
 
-  wxCriticalSection m_exclusive;  // protects the following three data structures
-  unsigned char m_data[SHADER_COLOR_CHANNELS * LINES_PER_ROTATION * RETURNS_PER_LINE];
+  void ProcessSpoke(GLubyte alpha, SpokeBearing angle, SpokeBearing heading, const SpokeSpan* spans, size_t span_count);
+  void DrawSector(int begin, int end, bool north_up);
+
+  wxCriticalSection m_exclusive;  // protects the following data structures
+  unsigned char m_data[SHADER_COLOR_CHANNELS * G::LINES * G::RETURNS];
   int m_start_line;
   int m_end_line;
+  UINT32 m_line_generation[G::LINES];     // m_generation when the line was last received
+  UINT32 m_generation;                    // Lines of other generations are stale and not drawn
+  int m_current_lines;                    // Lines of m_generation, the whole image is drawn when all are
+  SpokeBearing m_line_heading[G::LINES];  // bearing - angle when the line was last received
+  GLubyte m_heading_texels[G::LINES][2];  // The same as a 16 bit fraction of a rotation, for the shader
+  SpokeBearing m_last_heading;            // Heading of the last line received
+  bool m_headings_changed;                // m_heading_texels differs from m_heading_texture
 
   int m_format;
   int m_channels;
 
   GLuint m_texture;
+  GLuint m_heading_texture;
   GLuint m_fragment;
   GLuint m_vertex;
   GLuint m_program;
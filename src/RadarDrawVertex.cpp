@@ -33,12 +33,13 @@
 
 PLUGIN_BEGIN_NAMESPACE
 
-bool RadarDrawVertex::Init() { return true; }
+template <class G>
+bool RadarDrawVertex<G>::Init() { return true; }
 
 #define ADD_VERTEX_POINT(angle, radius, r, g, b, a)          \
   {                                                          \
-    line->points[count].x = m_polarLookup->x[angle][radius]; \
-    line->points[count].y = m_polarLookup->y[angle][radius]; \
+    line->points[count].x = m_polarLookup->x(angle, radius); \
+    line->points[count].y = m_polarLookup->y(angle, radius); \
     line->points[count].red = r;                             \
     line->points[count].green = g;                           \
     line->points[count].blue = b;                            \
@@ -46,13 +47,14 @@ bool RadarDrawVertex::Init() { return true; }
     count++;                                                 \
   }
 
-void RadarDrawVertex::SetBlob(VertexLine* line, int angle_begin, int angle_end, int r1, int r2, GLubyte red, GLubyte green,
-                              GLubyte blue, GLubyte alpha) {
+template <class G>
+void RadarDrawVertex<G>::SetBlob(VertexLine* line, int angle_begin, int angle_end, int r1, int r2, GLubyte red, GLubyte green,
+                                 GLubyte blue, GLubyte alpha) {
   if (r2 == 0) {
     return;
   }
-  int arc1 = MOD_ROTATION2048(angle_begin);
-  int arc2 = MOD_ROTATION2048(angle_end);
+  int arc1 = G::Mod(angle_begin);
+  int arc2 = G::Mod(angle_end);
   size_t count = line->count;
 
   if (line->count + VERTEX_PER_QUAD > line->allocated) {
@@ -84,19 +86,24 @@ void RadarDrawVertex::SetBlob(VertexLine* line, int angle_begin, int angle_end,
   line->count = count;
 }
 
-void RadarDrawVertex::ProcessRadarSpoke(int transparency, SpokeBearing angle, UINT8* data, size_t len) {
-  wxColour colour;
+template <class G>
+void RadarDrawVertex<G>::ProcessRadarSpokes(int transparency, const RadarSpoke* spokes, size_t count) {
   GLubyte alpha = 255 * (MAX_OVERLAY_TRANSPARENCY - transparency) / MAX_OVERLAY_TRANSPARENCY;
-  BlobColour previous_colour = BLOB_NONE;
-  GLubyte strength = 0;
   time_t now = time(0);
 
   wxCriticalSectionLocker lock(m_exclusive);
 
-  int r_begin = 0;
-  int r_end = 0;
+  for (size_t s = 0; s < count; s++) {
+    ProcessSpoke(alpha, now, spokes[s].angle, G::Mod(spokes[s].bearing - spokes[s].angle), spokes[s].spans,
+                 spokes[s].span_count);
+  }
+}
 
-  if (angle < 0 || angle >= LINES_PER_ROTATION) {
+// Caller holds m_exclusive
+template <class G>
+void RadarDrawVertex<G>::ProcessSpoke(GLubyte alpha, time_t now, SpokeBearing angle, SpokeBearing heading,
+                                      const SpokeSpan* spans, size_t span_count) {
+  if (angle < 0 || angle >= G::LINES) {
     return;
   }
 
@@ -119,60 +126,74 @@ void RadarDrawVertex::ProcessRadarSpoke(int transparency, SpokeBearing angle, UI
   }
   line->count = 0;
   line->timeout = now + m_ri->m_pi->m_settings.max_age;
+  line->generation = m_generation;
+  line->heading = heading;
 
-  for (size_t radius = 0; radius < len; radius++) {
-    strength = data[radius];
-    BlobColour actual_colour = m_ri->m_colour_map[strength];
-
-    if (actual_colour == previous_colour) {
-      // continue with same color, just register it
-      r_end++;
-    } else if (previous_colour == BLOB_NONE && actual_colour != BLOB_NONE) {
-      // blob starts, no display, just register
-      r_begin = radius;
-      r_end = r_begin + 1;
-      previous_colour = actual_colour;  // new color
-    } else if (previous_colour != BLOB_NONE && (previous_colour != actual_colour)) {
-      colour = m_ri->m_colour_map_rgb[previous_colour];
-
-      SetBlob(line, angle, angle + 1, r_begin, r_end, colour.Red(), colour.Green(), colour.Blue(), alpha);
-
-      previous_colour = actual_colour;
-      if (actual_colour != BLOB_NONE) {  // change of color, start new blob
-        r_begin = radius;
-        r_end = r_begin + 1;
-      }
-    }
+  // Each span is a blob of one colour
+  for (size_t i = 0; i < span_count; i++) {
+    wxColour colour = m_ri->m_colour_map_rgb[spans[i].colour];
+
+    SetBlob(line, angle, angle + 1, spans[i].start, spans[i].end, colour.Red(), colour.Green(), colour.Blue(), alpha);
   }
+}
+
+template <class G>
+void RadarDrawVertex<G>::ResetSpokes() {
+  wxCriticalSectionLocker lock(m_exclusive);
 
-  if (previous_colour != BLOB_NONE) {  // Draw final blob
-    colour = m_ri->m_colour_map_rgb[previous_colour];
+  m_generation++;
+}
 
-    SetBlob(line, angle, angle + 1, r_begin, r_end, colour.Red(), colour.Green(), colour.Blue(), alpha);
+template <class G>
+void RadarDrawVertex<G>::ProcessPlaceholderSpokes(int transparency, const RadarSpoke* spokes, size_t count) {
+  GLubyte alpha = 255 * (MAX_OVERLAY_TRANSPARENCY - transparency) / MAX_OVERLAY_TRANSPARENCY;
+  time_t now = time(0);
+
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  for (size_t s = 0; s < count; s++) {
+    SpokeBearing angle = spokes[s].angle;
+    if (angle >= 0 && angle < G::LINES && m_vertices[angle].generation != m_generation) {
+      ProcessSpoke(alpha, now, angle, G::Mod(spokes[s].bearing - angle), spokes[s].spans, spokes[s].span_count);
+    }
   }
 }
 
-void RadarDrawVertex::DrawRadarImage() {
+template <class G>
+void RadarDrawVertex<G>::DrawRadarImage(bool north_up) {
   glEnableClientState(GL_VERTEX_ARRAY);
   glEnableClientState(GL_COLOR_ARRAY);
+  glPushMatrix();
 
   time_t now = time(0);
   {
     wxCriticalSectionLocker lock(m_exclusive);
+    SpokeBearing rotation = 0;
 
-    for (size_t i = 0; i < LINES_PER_ROTATION; i++) {
+    for (size_t i = 0; i < G::LINES; i++) {
       VertexLine* line = &m_vertices[i];
-      if (!line->count || TIMED_OUT(now, line->timeout)) {
+      if (!line->count || line->generation != m_generation || TIMED_OUT(now, line->timeout)) {
         continue;
       }
+      if (north_up && line->heading != rotation) {
+        // The heading hardly changes between lines, so this is only done a few times per image
+        rotation = line->heading;
+        glPopMatrix();
+        glPushMatrix();
+        glRotated(rotation * (double)DEGREES_PER_ROTATION / G::LINES, 0.0, 0.0, 1.0);
+      }
 
       glVertexPointer(2, GL_FLOAT, sizeof(VertexPoint), &line->points[0].x);
       glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(VertexPoint), &line->points[0].red);
       glDrawArrays(GL_TRIANGLES, 0, line->count);
     }
   }
+  glPopMatrix();
   glDisableClientState(GL_VERTEX_ARRAY);  // disable vertex arrays
   glDisableClientState(GL_COLOR_ARRAY);
 }
 
+template class RadarDrawVertex<GeometryStandard>;
+template class RadarDrawVertex<GeometryHD>;
+
 PLUGIN_END_NAMESPACE
@@ -39,6 +39,7 @@ PLUGIN_BEGIN_NAMESPACE
 
 #define BUFFER_SIZE (2000000)
 
+template <class G>
 class RadarDrawVertex : public RadarDraw {
  public:
   RadarDrawVertex(RadarInfo* ri) {
@@ -51,21 +52,26 @@ class RadarDrawVertex : public RadarDraw {
       m_vertices[i].allocated = 0;
       m_vertices[i].timeout = 0;
       m_vertices[i].points = 0;
+      m_vertices[i].generation = 0;
+      m_vertices[i].heading = 0;
     }
+    m_generation = 1;
     m_count = 0;
     m_oom = false;
 
-    m_polarLookup = GetPolarToCartesianLookupTable();
+    m_polarLookup = GetPolarToCartesianLookupTable<G>();
   }
 
   bool Init();
-  void DrawRadarImage();
-  void ProcessRadarSpoke(int transparency, SpokeBearing angle, UINT8* data, size_t len);
+  void DrawRadarImage(bool north_up);
+  void ProcessRadarSpokes(int transparency, const RadarSpoke* spokes, size_t count);
+  void ResetSpokes();
+  void ProcessPlaceholderSpokes(int transparency, const RadarSpoke* spokes, size_t count);
 
   ~RadarDrawVertex() {
     wxCriticalSectionLocker lock(m_exclusive);
 
-    for (size_t i = 0; i < LINES_PER_ROTATION; i++) {
+    for (size_t i = 0; i < G::LINES; i++) {
       if (m_vertices[i].points) {
         free(m_vertices[i].points);
       }
@@ -75,9 +81,12 @@ class RadarDrawVertex : public RadarDraw {
  private:
   RadarInfo* m_ri;
 
+  void ProcessSpoke(GLubyte alpha, time_t now, SpokeBearing angle, SpokeBearing heading, const SpokeSpan* spans,
+                    size_t span_count);
+
   static const int VERTEX_PER_TRIANGLE = 3;
   static const int VERTEX_PER_QUAD = 2 * VERTEX_PER_TRIANGLE;
-  static const int MAX_BLOBS_PER_LINE = RETURNS_PER_LINE;
+  static const int MAX_BLOBS_PER_LINE = G::RETURNS;
 
   struct VertexPoint {
     GLfloat x;
@@ -93,12 +102,15 @@ class RadarDrawVertex : public RadarDraw {
     time_t timeout;
     size_t count;
     size_t allocated;
+    UINT32 generation;     // m_generation when the line was last received
+    SpokeBearing heading;  // bearing - angle when the line was last received
   };
 
-  PolarToCartesianLookupTable* m_polarLookup;
+  PolarToCartesianLookupTable<G>* m_polarLookup;
 
   wxCriticalSection m_exclusive;  // protects the following
-  VertexLine m_vertices[LINES_PER_ROTATION];
+  VertexLine m_vertices[G::LINES];
+  UINT32 m_generation;  // Lines of other generations are stale
   unsigned int m_count;
   bool m_oom;
 
@@ -0,0 +1,107 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "br24radar_pi.h"
+#include "RadarFrame.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+RadarFramePool::RadarFramePool() {
+  m_published = 0;
+  m_dropped = 0;
+  m_latest = 0;
+  for (size_t i = 0; i < RADAR_FRAME_POOL_SIZE; i++) {
+    m_frames[i] = 0;
+  }
+}
+
+RadarFramePool::~RadarFramePool() {
+  for (size_t i = 0; i < RADAR_FRAME_POOL_SIZE; i++) {
+    delete m_frames[i];
+  }
+}
+
+RadarFrame *RadarFramePool::Acquire(RadarGeometryType geometry, int range_meters) {
+  RadarFrame *frame = 0;
+
+  // A frame at 0 references is not the latest and cannot be found by GetLatest(), so
+  // nothing else can take it while it is set up here.
+  for (size_t i = 0; i < RADAR_FRAME_POOL_SIZE && !frame; i++) {
+    if (!m_frames[i]) {
+      m_frames[i] = new RadarFrame;  // Only until every frame has been used once
+      m_frames[i]->m_refs = 0;
+    }
+    if (__atomic_load_n(&m_frames[i]->m_refs, __ATOMIC_ACQUIRE) == 0) {
+      frame = m_frames[i];
+    }
+  }
+  if (!frame) {
+    m_dropped++;
+    return 0;
+  }
+
+  frame->m_refs = 1;
+  frame->geometry = geometry;
+  frame->lines = GeometryLines(geometry);
+  frame->returns = GeometryReturns(geometry);
+  frame->range_meters = range_meters;
+  frame->timestamp = 0;
+  frame->rotation = 0;
+  memset(frame->heading, 0xff, frame->lines * sizeof(frame->heading[0]));
+  memset(frame->samples, 0, frame->lines * frame->returns);
+  return frame;
+}
+
+void RadarFramePool::Publish(RadarFrame *frame) {
+  RadarFrame *previous;
+
+  frame->timestamp = wxGetUTCTimeMillis();
+  frame->rotation = m_published++;
+  {
+    wxCriticalSectionLocker lock(m_lock);
+    previous = m_latest;
+    m_latest = frame;
+  }
+  if (previous) {
+    previous->Release();
+  }
+}
+
+RadarFrame *RadarFramePool::GetLatest() {
+  wxCriticalSectionLocker lock(m_lock);
+
+  if (m_latest) {
+    m_latest->AddRef();
+  }
+  return m_latest;
+}
+
+PLUGIN_END_NAMESPACE
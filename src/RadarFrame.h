@@ -0,0 +1,109 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _RADAR_FRAME_POOL_H_
+#define _RADAR_FRAME_POOL_H_
+
+#include "RadarGeometry.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define RADAR_FRAME_POOL_SIZE (4)  // Frames per radar: one being filled, the latest and two held by readers
+
+class RadarFramePool;
+
+/*
+ * One complete rotation of spokes, relative to the boat, as they came out of the
+ * multi sweep filter. Line 0 is dead ahead. A frame is filled by RadarInfo from one
+ * pass through line 0 to the next and does not change once it has been published, so a
+ * reader that holds a reference can use it from any thread without a lock. Readers
+ * call RadarInfo::AddFrameReader() first, see CRMFrameExport.
+ */
+class RadarFrame {
+ public:
+  RadarGeometryType geometry;
+  int lines;    // Of the geometry
+  int returns;  // Of the geometry, the stride of samples
+  int range_meters;
+  wxLongLong timestamp;  // UTC millis when the frame was published
+  unsigned long rotation;  // Frames published by the pool before this one
+
+  SpokeBearing heading[MAX_GEOMETRY_LINES];  // Of the boat in geometry lines, -1 when the line was not received
+  UINT8 samples[MAX_GEOMETRY_LINES * MAX_GEOMETRY_RETURNS];
+
+  const UINT8 *Line(int line) const { return samples + line * returns; }
+
+  void AddRef() { __atomic_add_fetch(&m_refs, 1, __ATOMIC_RELAXED); }
+  void Release() { __atomic_sub_fetch(&m_refs, 1, __ATOMIC_RELEASE); }  // Free for the pool at 0
+
+ private:
+  friend class RadarFramePool;
+
+  int m_refs;
+};
+
+/*
+ * A fixed set of frames that are reused, so no memory is allocated once every frame
+ * has been used once. The pool holds a reference to the latest frame, readers add
+ * their own with GetLatest().
+ *
+ * Acquire() and Publish() are called by one thread at a time (the spoke pipeline,
+ * under RadarInfo::m_exclusive). GetLatest() may be called from any thread. All
+ * references must be released before the pool is deleted.
+ */
+class RadarFramePool {
+ public:
+  RadarFramePool();
+  ~RadarFramePool();
+
+  // A frame that nobody holds, with one reference, cleared for the geometry. 0 when
+  // every frame is in use.
+  RadarFrame *Acquire(RadarGeometryType geometry, int range_meters);
+
+  // Makes frame the latest. The reference of the caller passes to the pool, and the
+  // reference of the pool to the previous latest frame is released.
+  void Publish(RadarFrame *frame);
+
+  // The latest frame with a reference added for the caller, 0 when there is none yet
+  RadarFrame *GetLatest();
+
+  unsigned long m_published;
+  unsigned long m_dropped;  // Rotations that found no free frame
+
+ private:
+  wxCriticalSection m_lock;  // Held only to change m_latest and to take a reference to it
+  RadarFrame *m_frames[RADAR_FRAME_POOL_SIZE];
+  RadarFrame *m_latest;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RADAR_FRAME_POOL_H_ */
@@ -0,0 +1,73 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _RADAR_GEOMETRY_H_
+#define _RADAR_GEOMETRY_H_
+
+#include "br24radar_pi.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+enum RadarGeometryType { GEOMETRY_STANDARD, GEOMETRY_HD };
+
+/*
+ * Spoke geometry of a radar: the number of lines (spokes) per rotation and the
+ * number of returns (samples) per line. The spoke store, the lookup tables and
+ * the draw implementations are templates on this, so the array sizes and loop
+ * bounds are constants in every instantiation.
+ *
+ * The radar reports azimuths in lines, 0 .. LINES - 1.
+ */
+template <RadarGeometryType T, int L, int R>
+struct RadarGeometry {
+  static const RadarGeometryType TYPE = T;
+  static const int LINES = L;
+  static const int RETURNS = R;
+  static const int TRAILS = R * 2;  // Size of the true motion trails image, R must be a power of 2
+
+  static SpokeBearing Mod(int line) { return (line + 2 * LINES) % LINES; }
+  static int DegreesToLines(double angle) { return (int)(angle * (double)LINES / DEGREES_PER_ROTATION); }
+};
+
+typedef RadarGeometry<GEOMETRY_STANDARD, LINES_PER_ROTATION, RETURNS_PER_LINE> GeometryStandard;
+typedef RadarGeometry<GEOMETRY_HD, LINES_PER_ROTATION, 1024> GeometryHD;  // Same azimuths, twice the returns
+
+#define MAX_GEOMETRY_LINES (GeometryHD::LINES)
+#define MAX_GEOMETRY_RETURNS (GeometryHD::RETURNS)
+
+inline int GeometryLines(RadarGeometryType type) { return type == GEOMETRY_HD ? GeometryHD::LINES : GeometryStandard::LINES; }
+inline int GeometryReturns(RadarGeometryType type) {
+  return type == GEOMETRY_HD ? GeometryHD::RETURNS : GeometryStandard::RETURNS;
+}
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RADAR_GEOMETRY_H_ */
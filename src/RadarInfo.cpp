@@ -42,10 +42,11 @@ PLUGIN_BEGIN_NAMESPACE
 
 bool g_first_render = true;
 
-enum { TIMER_ID = 1 };
+enum { TIMER_ID = 1, GUARD_ZONE_EVENT_ID };
 
 BEGIN_EVENT_TABLE(RadarInfo, wxEvtHandler)
 EVT_TIMER(TIMER_ID, RadarInfo::RefreshDisplay)
+EVT_COMMAND(GUARD_ZONE_EVENT_ID, wxEVT_COMMAND_TEXT_UPDATED, RadarInfo::OnGuardZoneEvent)
 END_EVENT_TABLE()
 
 static const RadarRange g_ranges_metric[] = {
@@ -172,6 +173,55 @@ void radar_range_control_item::Update(int v) {
   }
 }
 
+#define STAGE_MAIN_BANG wxT("main bang")
+#define STAGE_CFAR wxT("cfar")
+#define STAGE_HISTORY wxT("history")
+#define STAGE_GUARD_ZONES wxT("guard zones")
+#define STAGE_MULTI_SWEEP_FILTER wxT("multi sweep filter")
+#define STAGE_FRAME wxT("frame")
+#define STAGE_SPANS wxT("spans")
+#define STAGE_OVERLAY wxT("overlay")
+#define STAGE_TRAILS wxT("trails")
+#define STAGE_OVERLAY_TRAILS wxT("overlay trails")
+#define STAGE_PANEL wxT("panel")
+#define STAGE_ROTATION wxT("rotation")
+
+// The settings that decide which spoke stages run and which kernel each one uses
+enum SpokeFeature {
+  SPOKE_MAIN_BANG = 1 << 0,
+  SPOKE_FILTER = 1 << 1,        // Multi sweep filter on the image
+  SPOKE_GUARD_ZONES = 1 << 2,
+  SPOKE_GUARD_FILTER = 1 << 3,  // A guard zone uses the multi sweep filter
+  SPOKE_TRAILS = 1 << 4,
+  SPOKE_TRUE_TRAILS = 1 << 5,
+  SPOKE_OVERLAY = 1 << 6,
+  SPOKE_TRAILS_ON_OVERLAY = 1 << 7,
+  SPOKE_PANEL = 1 << 8,
+  SPOKE_FRAMES = 1 << 9,  // Someone reads the RadarFrames
+  SPOKE_CFAR = 1 << 10
+};
+
+// Runs a RadarInfo method as a spoke stage. Methods that depend on the geometry are
+// templates; the instance for the geometry of the batch is called.
+class RadarInfoStage : public SpokeStage {
+ public:
+  typedef void (RadarInfo::*Method)(SpokeBatch *batch);
+
+  RadarInfoStage(RadarInfo *ri, Method method) : m_ri(ri), m_standard(method), m_hd(method) {}
+  RadarInfoStage(RadarInfo *ri, Method standard, Method hd) : m_ri(ri), m_standard(standard), m_hd(hd) {}
+
+  void Process(SpokeBatch *batch) { (m_ri->*(batch->geometry == GEOMETRY_HD ? m_hd : m_standard))(batch); }
+  void SetMethods(Method standard, Method hd) {
+    m_standard = standard;
+    m_hd = hd;
+  }
+
+ private:
+  RadarInfo *m_ri;
+  Method m_standard;
+  Method m_hd;
+};
+
 RadarInfo::RadarInfo(br24radar_pi *pi, int radar) {
   m_pi = pi;
   m_radar = radar;
@@ -203,7 +253,12 @@ RadarInfo::RadarInfo(br24radar_pi *pi, int radar) {
 #endif
   m_radarControl = 0;
   m_draw_panel.draw = 0;
+  m_draw_panel.geometry = GEOMETRY_STANDARD;
   m_draw_overlay.draw = 0;
+  m_draw_overlay.geometry = GEOMETRY_STANDARD;
+  m_geometry = GEOMETRY_STANDARD;
+  m_store_standard = new RadarSpokeStore<GeometryStandard>();
+  m_store_hd = 0;
   m_radar_panel = 0;
   m_radar_canvas = 0;
   m_control_dialog = 0;
@@ -212,12 +267,43 @@ RadarInfo::RadarInfo(br24radar_pi *pi, int radar) {
   m_state.button = 0;
   m_range.m_settings = &m_pi->m_settings;
 
-  for (size_t z = 0; z < GUARD_ZONES; z++) {
+  for (size_t z = 0; z < GUARD_ZONES_MAX; z++) {
     m_guard_zone[z] = new GuardZone(pi, radar, z);
   }
 
   ComputeTargetTrails();
 
+  m_history_stage = new RadarInfoStage(this, &RadarInfo::StageHistory<GeometryStandard, false>,
+                                       &RadarInfo::StageHistory<GeometryHD, false>);
+  m_trails_stage = new RadarInfoStage(this, &RadarInfo::StageTrails<GeometryStandard, TARGET_MOTION_RELATIVE>,
+                                      &RadarInfo::StageTrails<GeometryHD, TARGET_MOTION_RELATIVE>);
+  m_spoke_pipeline.Add(STAGE_MAIN_BANG, new RadarInfoStage(this, &RadarInfo::StageMainBang));
+  m_spoke_pipeline.Add(STAGE_CFAR, new RadarInfoStage(this, &RadarInfo::StageCfar));
+  m_spoke_pipeline.Add(STAGE_HISTORY, m_history_stage);
+  m_spoke_pipeline.Add(STAGE_GUARD_ZONES, new RadarInfoStage(this, &RadarInfo::StageGuardZones));
+  m_spoke_pipeline.Add(STAGE_MULTI_SWEEP_FILTER, new RadarInfoStage(this, &RadarInfo::StageMultiSweepFilter));
+  m_spoke_pipeline.Add(STAGE_FRAME, new RadarInfoStage(this, &RadarInfo::StageFrame<GeometryStandard>,
+                                                       &RadarInfo::StageFrame<GeometryHD>));
+  m_spoke_pipeline.Add(STAGE_SPANS, new RadarInfoStage(this, &RadarInfo::StageSpans));
+  m_spoke_pipeline.Add(STAGE_OVERLAY, new RadarInfoStage(this, &RadarInfo::StageOverlay));
+  m_spoke_pipeline.Add(STAGE_ROTATION, new RadarInfoStage(this, &RadarInfo::StageRotation<GeometryStandard>,
+                                                          &RadarInfo::StageRotation<GeometryHD>));
+  m_spoke_pipeline.Add(STAGE_TRAILS, m_trails_stage);  // Paints trail colours into the data, keep it after the rotation
+  m_spoke_pipeline.Add(STAGE_OVERLAY_TRAILS, new RadarInfoStage(this, &RadarInfo::StageOverlay));
+  m_spoke_pipeline.Add(STAGE_PANEL, new RadarInfoStage(this, &RadarInfo::StagePanel));
+  SelectSpokeKernels(0);
+
+  m_resample_thread = new RadarResampleThread(this);
+  m_resample_thread->Run();
+  m_guard_zone_event_posted = 0;
+  m_cfar_current = 0;
+  m_cfar_geometry = GEOMETRY_STANDARD;
+  m_cfar_angle = 0;
+  m_cfar_len = 0;
+  m_frame = 0;
+  m_frame_last_line = 0;
+  m_frame_readers = 0;
+
   m_timer = new wxTimer(this, TIMER_ID);
   m_overlay_refreshes_queued = 0;
   m_refreshes_queued = 0;
@@ -237,14 +323,14 @@ void RadarInfo::DeleteDialogs() {
 
 RadarInfo::~RadarInfo() {
   m_timer->Stop();
+  m_resample_thread->Shutdown();
+  m_resample_thread->Wait();
+  delete m_resample_thread;
+  m_resample_thread = 0;
   if (m_radarControl) {
-    LOG_VERBOSE(wxT("BR24radar_pi: %s receive thread request stop"), m_name.c_str());
-    m_radarControl->Shutdown();
-    LOG_VERBOSE(wxT("BR24radar_pi: %s receive thread stopped"), m_name.c_str());
-    m_radarControl->Wait();
-    LOG_VERBOSE(wxT("BR24radar_pi: %s receive thread delete"), m_name.c_str());
+    // The I/O reactor has already been stopped, which stopped this control as well.
     delete m_radarControl;
-    LOG_VERBOSE(wxT("BR24radar_pi: %s receive thread deleted"), m_name.c_str());
+    LOG_VERBOSE(wxT("BR24radar_pi: %s receive control deleted"), m_name.c_str());
     m_radarControl = 0;
   }
   DeleteDialogs();
@@ -262,7 +348,14 @@ RadarInfo::~RadarInfo() {
     m_transmit = 0;
   }
 #endif
-  for (size_t z = 0; z < GUARD_ZONES; z++) {
+  if (m_frame) {
+    m_frame->Release();
+  }
+  delete m_store_standard;
+  if (m_store_hd) {
+    delete m_store_hd;
+  }
+  for (size_t z = 0; z < GUARD_ZONES_MAX; z++) {
     delete m_guard_zone[z];
     m_guard_zone[z] = 0;
   }
@@ -339,10 +432,11 @@ void RadarInfo::SetName(wxString name) {
 
 void RadarInfo::StartReceive() {
   if (!m_radarControl) {
-    LOG_RECEIVE(wxT("BR24radar_pi: %s starting receive thread"), m_name.c_str());
+    LOG_RECEIVE(wxT("BR24radar_pi: %s starting receive"), m_name.c_str());
     m_radarControl = new CRMControl(m_pi, this);
-    if (!m_radarControl || (m_radarControl->Run() != wxTHREAD_NO_ERROR)) {
-      LOG_INFO(wxT("BR24radar_pi: %s unable to start receive thread."), m_name.c_str());
+    if (!m_pi->m_reactor || !m_pi->m_reactor->AddRadar(m_radarControl)) {
+      LOG_INFO(wxT("BR24radar_pi: %s unable to start receive."), m_name.c_str());
+      delete m_radarControl;
       m_radarControl = 0;
     }
   }
@@ -386,28 +480,32 @@ void RadarInfo::ComputeColourMap() {
 }
 
 void RadarInfo::ResetSpokes() {
-  UINT8 zap[RETURNS_PER_LINE];
+  uint64_t start = ThreadCpuNanos();
 
   LOG_VERBOSE(wxT("BR24radar_pi: reset spokes, history and trails"));
 
-  memset(zap, 0, sizeof(zap));
-  memset(m_history, 0, sizeof(m_history));
+  if (m_geometry == GEOMETRY_HD) {
+    m_store_hd->ClearHistory();
+  } else {
+    m_store_standard->ClearHistory();
+  }
   ClearTrails();
+  m_cfar_len = 0;
 
-  if (m_draw_panel.draw) {
-    for (size_t r = 0; r < LINES_PER_ROTATION; r++) {
-      m_draw_panel.draw->ProcessRadarSpoke(0, r, zap, sizeof(zap));
-    }
+  // A draw made for another geometry is replaced on the next render
+  if (m_draw_panel.draw && m_draw_panel.geometry == m_geometry) {
+    m_draw_panel.draw->ResetSpokes();
   }
-  if (m_draw_overlay.draw) {
-    for (size_t r = 0; r < LINES_PER_ROTATION; r++) {
-      m_draw_overlay.draw->ProcessRadarSpoke(0, r, zap, sizeof(zap));
-    }
+  if (m_draw_overlay.draw && m_draw_overlay.geometry == m_geometry) {
+    m_draw_overlay.draw->ResetSpokes();
   }
-  for (size_t z = 0; z < GUARD_ZONES; z++) {
+  for (size_t z = 0; z < GUARD_ZONES_MAX; z++) {
     // Zap them anyway just to be sure
     m_guard_zone[z]->ResetBogeys();
   }
+
+  m_statistics.resets++;
+  m_statistics.reset_micros += (int)((ThreadCpuNanos() - start) / 1000);
 }
 
 /*
@@ -421,108 +519,558 @@ void RadarInfo::ResetSpokes() {
  * @param range                 Range (in meters) of this data
  */
 void RadarInfo::ProcessRadarSpoke(SpokeBearing angle, SpokeBearing bearing, UINT8 *data, size_t len, int range_meters) {
+  RadarSpoke spoke;
+
+  spoke.angle = angle;
+  spoke.bearing = bearing;
+  spoke.data = data;
+  spoke.len = len;
+  ProcessRadarSpokes(GEOMETRY_STANDARD, &spoke, 1, range_meters);
+}
+
+template <>
+RadarSpokeStore<GeometryStandard> *RadarInfo::GetStore<GeometryStandard>() {
+  return m_store_standard;
+}
+
+template <>
+RadarSpokeStore<GeometryHD> *RadarInfo::GetStore<GeometryHD>() {
+  return m_store_hd;
+}
+
+/*
+ * All spokes of one received packet. The settings are read and each lock is taken
+ * once for the whole batch, instead of once per spoke.
+ *
+ * The batch goes through the stages of m_spoke_pipeline, each stage handling all
+ * spokes before the next one starts. No stage uses the result of a later spoke, so
+ * the result is the same as calling ProcessRadarSpoke() for each spoke in turn.
+ * Longer batches are split into SPOKE_BATCH_MAX spokes.
+ *
+ * The spokes of one batch all have the same geometry. When it differs from the previous
+ * batch the history and trails are reset, and the draws are replaced on the next render.
+ *
+ * @param geometry              Lines per rotation and returns per line of the spokes
+ * @param spokes                The spokes, data is modified in place.
+ * @param count                 Number of spokes
+ * @param range                 Range (in meters) of this data
+ */
+void RadarInfo::ProcessRadarSpokes(RadarGeometryType geometry, RadarSpoke *spokes, size_t count, int range_meters) {
   wxCriticalSectionLocker lock(m_exclusive);
 
-  for (int i = 0; i < m_pi->m_settings.main_bang_size; i++) {
-    data[i] = 0;
+  if (geometry != m_geometry) {
+    if (geometry == GEOMETRY_HD && !m_store_hd) {
+      m_store_hd = new RadarSpokeStore<GeometryHD>();
+    }
+    m_geometry = geometry;
+    LOG_VERBOSE(wxT("BR24radar_pi: %s spokes now have %d lines of %d returns"), m_name.c_str(), GeometryLines(geometry),
+                GeometryReturns(geometry));
+    ResetSpokes();
+  }
+
+  for (size_t done = 0; done < count; done += SPOKE_BATCH_MAX) {
+    size_t n = wxMin(count - done, (size_t)SPOKE_BATCH_MAX);
+    if (geometry == GEOMETRY_HD) {
+      ProcessSpokes<GeometryHD>(spokes + done, n, range_meters);
+    } else {
+      ProcessSpokes<GeometryStandard>(spokes + done, n, range_meters);
+    }
   }
+}
 
+// Caller holds m_exclusive
+template <class G>
+void RadarInfo::ProcessSpokes(RadarSpoke *spokes, size_t count, int range_meters) {
   if (m_range_meters != range_meters) {
     ResetSpokes();
+    StartResample<G>(range_meters);
     LOG_VERBOSE(wxT("BR24radar_pi: %s detected spoke range change from %d to %d meters"), m_name.c_str(), m_range_meters,
                 range_meters);
     m_range_meters = range_meters;
     if (!m_range.value) {
       m_range.Update(convertSpokeMetersToRangeMeters(range_meters));
     }
+  }
 
-  } else if (m_orientation.mod) {
-    ResetSpokes();
-    LOG_VERBOSE(wxT("BR24radar_pi: %s HeadUp/NorthUp change"));
+  unsigned features = GetSpokeFeatures();
+  if (features != m_spoke_features) {
+    SelectSpokeKernels(features);
   }
-  int north_up = m_orientation.GetButton() == ORIENTATION_NORTH_UP;
-  uint8_t weakest_normal_blob = m_pi->m_settings.threshold_blue;
 
-  bool calc_history = m_multi_sweep_filter;
-  for (size_t z = 0; z < GUARD_ZONES; z++) {
-    if (m_guard_zone[z]->m_type != GZ_OFF && m_guard_zone[z]->m_multi_sweep_filter) {
-      calc_history = true;
-    }
+  SpokeBatch batch;
+  batch.geometry = G::TYPE;
+  batch.spokes = spokes;
+  batch.count = count;
+  batch.range_meters = range_meters;
+  m_spoke_pipeline.Process(&batch);
+}
+
+// Caller holds m_exclusive
+unsigned RadarInfo::GetSpokeFeatures() {
+  unsigned features = 0;
+
+  if (m_pi->m_settings.main_bang_size > 0) {
+    features |= SPOKE_MAIN_BANG;
   }
-  if (calc_history) {
-    UINT8 *hist_data = m_history[angle];
-    for (size_t radius = 0; radius < len; radius++) {
-      hist_data[radius] = hist_data[radius] << 1;  // shift left history byte 1 bit
-      if (data[radius] >= weakest_normal_blob) {
-        hist_data[radius] = hist_data[radius] | 1;  // and add 1 if above threshold
+  if (m_multi_sweep_filter) {
+    features |= SPOKE_FILTER;
+  }
+  if (m_pi->m_settings.cfar_on) {
+    features |= SPOKE_CFAR;
+  }
+  for (size_t z = 0; z < GUARD_ZONES_MAX; z++) {
+    if (m_guard_zone[z]->m_type != GZ_OFF) {
+      features |= SPOKE_GUARD_ZONES;
+      if (m_guard_zone[z]->m_multi_sweep_filter) {
+        features |= SPOKE_GUARD_FILTER;
       }
     }
   }
+  if (m_target_trails.value != 0) {
+    features |= SPOKE_TRAILS;
+    if (m_trails_motion.value == TARGET_MOTION_TRUE) {
+      features |= SPOKE_TRUE_TRAILS;
+    }
+  }
+  if (m_draw_overlay.draw) {
+    features |= SPOKE_OVERLAY;
+  }
+  if (m_pi->m_settings.trails_on_overlay == 1) {
+    features |= SPOKE_TRAILS_ON_OVERLAY;
+  }
+  if (m_draw_panel.draw) {
+    features |= SPOKE_PANEL;
+  }
+  if (__atomic_load_n(&m_frame_readers, __ATOMIC_RELAXED) > 0) {
+    features |= SPOKE_FRAMES;
+  }
+  return features;
+}
 
-  for (size_t z = 0; z < GUARD_ZONES; z++) {
+/*
+ * Switches off the stages that have nothing to do with these settings and points the
+ * others at the kernel made for them, so the sample loops do not test the settings.
+ * Called when the settings seen by a batch differ from the previous batch.
+ *
+ * Caller holds m_exclusive
+ */
+void RadarInfo::SelectSpokeKernels(unsigned features) {
+  bool filter = (features & (SPOKE_FILTER | SPOKE_GUARD_FILTER)) != 0;
+  bool overlay = (features & SPOKE_OVERLAY) != 0;
+  bool trails_on_overlay = (features & SPOKE_TRAILS_ON_OVERLAY) != 0;
+
+  m_spoke_pipeline.SetActive(STAGE_MAIN_BANG, (features & SPOKE_MAIN_BANG) != 0);
+  m_spoke_pipeline.SetActive(STAGE_CFAR, (features & SPOKE_CFAR) != 0);
+  m_spoke_pipeline.SetActive(STAGE_HISTORY, (features & (SPOKE_FILTER | SPOKE_GUARD_ZONES)) != 0);
+  if (filter) {
+    m_history_stage->SetMethods(&RadarInfo::StageHistory<GeometryStandard, true>, &RadarInfo::StageHistory<GeometryHD, true>);
+  } else {
+    m_history_stage->SetMethods(&RadarInfo::StageHistory<GeometryStandard, false>, &RadarInfo::StageHistory<GeometryHD, false>);
+  }
+  m_spoke_pipeline.SetActive(STAGE_GUARD_ZONES, (features & SPOKE_GUARD_ZONES) != 0);
+  m_spoke_pipeline.SetActive(STAGE_MULTI_SWEEP_FILTER, (features & SPOKE_FILTER) != 0);
+  m_spoke_pipeline.SetActive(STAGE_FRAME, (features & SPOKE_FRAMES) != 0);
+  if (!(features & SPOKE_FRAMES) && m_frame) {
+    m_frame->Release();
+    m_frame = 0;
+  }
+  m_spoke_pipeline.SetActive(STAGE_SPANS, (features & (SPOKE_OVERLAY | SPOKE_TRAILS | SPOKE_PANEL)) != 0);
+  m_spoke_pipeline.SetActive(STAGE_OVERLAY, overlay && !trails_on_overlay);
+  m_spoke_pipeline.SetActive(STAGE_TRAILS, (features & SPOKE_TRAILS) != 0);
+  if (features & SPOKE_TRUE_TRAILS) {
+    m_trails_stage->SetMethods(&RadarInfo::StageTrails<GeometryStandard, TARGET_MOTION_TRUE>,
+                               &RadarInfo::StageTrails<GeometryHD, TARGET_MOTION_TRUE>);
+  } else {
+    m_trails_stage->SetMethods(&RadarInfo::StageTrails<GeometryStandard, TARGET_MOTION_RELATIVE>,
+                               &RadarInfo::StageTrails<GeometryHD, TARGET_MOTION_RELATIVE>);
+  }
+  m_spoke_pipeline.SetActive(STAGE_OVERLAY_TRAILS, overlay && trails_on_overlay);
+  m_spoke_pipeline.SetActive(STAGE_PANEL, (features & SPOKE_PANEL) != 0);
+
+  LOG_VERBOSE(wxT("BR24radar_pi: %s spoke features %x"), m_name.c_str(), features);
+  m_spoke_features = features;
+}
+
+/*
+ * The standard spoke stages, in the order they are added to m_spoke_pipeline.
+ * Each runs only while SelectSpokeKernels() has it active.
+ * All are called with m_exclusive held.
+ */
+
+void RadarInfo::StageMainBang(SpokeBatch *batch) {
+  int main_bang_size = m_pi->m_settings.main_bang_size;
+
+  for (size_t s = 0; s < batch->count; s++) {
+    size_t n = wxMin((size_t)main_bang_size, batch->spokes[s].len);
+    memset(batch->spokes[s].data, 0, n);
+  }
+}
+
+/*
+ * Zeroes the returns that the CFAR detector does not find, so the colour map, the
+ * history planes and with them the guard zones and the multi sweep filter only see
+ * targets. The previous spoke is used for the noise average when it is the same or
+ * the line before, with the same length.
+ */
+void RadarInfo::StageCfar(SpokeBatch *batch) {
+  int lines = GeometryLines(batch->geometry);
+  CfarWindow window;
+
+  window.guard = m_pi->m_settings.cfar_guard;
+  window.train = m_pi->m_settings.cfar_training;
+  window.scale = (float)m_pi->m_settings.cfar_scale;
+
+  for (size_t s = 0; s < batch->count; s++) {
+    RadarSpoke *spoke = &batch->spokes[s];
+    size_t len = wxMin(spoke->len, GeometryReturns(batch->geometry));
+    const uint32_t *previous = m_cfar_sums[m_cfar_current];
+    bool neighbour = m_pi->m_settings.cfar_azimuth && m_cfar_len == len && m_cfar_geometry == batch->geometry &&
+                     (spoke->angle - m_cfar_angle + lines) % lines <= 1;
+
+    m_cfar_current ^= 1;
+    CfarPrefixSums(spoke->data, len, m_cfar_sums[m_cfar_current]);
+    CfarDetect(spoke->data, len, m_cfar_sums[m_cfar_current], neighbour ? previous : 0, window, m_cfar_detect);
+    HistoryApply(spoke->data, len, m_cfar_detect);
+
+    m_cfar_geometry = batch->geometry;
+    m_cfar_angle = spoke->angle;
+    m_cfar_len = len;
+  }
+}
+
+// Adds each spoke to the multi sweep history and, when FILTER is set, works out the
+// M-of-N filter. The history plane of a sweep is also the set of returns that guard
+// zones count.
+template <class G, bool FILTER>
+void RadarInfo::StageHistory(SpokeBatch *batch) {
+  RadarSpokeStore<G> *store = GetStore<G>();
+  uint8_t weakest_normal_blob = m_pi->m_settings.threshold_blue;
+  unsigned filter_m = m_pi->m_settings.multi_sweep_filter_m;
+  unsigned filter_n = m_pi->m_settings.multi_sweep_filter_n;
+  const size_t words = HISTORY_WORDS(G::RETURNS);
+
+  for (size_t s = 0; s < batch->count; s++) {
+    SpokeBearing angle = batch->spokes[s].angle;
+    size_t len = wxMin(batch->spokes[s].len, (size_t)G::RETURNS);
+
+    unsigned newest = (store->history_newest[angle] + 1) & (HISTORY_SWEEPS - 1);
+    store->history_newest[angle] = newest;
+    HistoryWord *strong = store->history[angle][newest];
+    HistoryThreshold(batch->spokes[s].data, len, weakest_normal_blob, strong);
+    batch->strong[s] = strong;
+    if (FILTER) {
+      HistoryFilter(store->history[angle][0], words, newest, filter_n, filter_m, m_allow[s]);
+      batch->allow[s] = m_allow[s];
+    }
+  }
+}
+
+// All zones are counted from the history plane of each spoke while it is in the cache
+void RadarInfo::StageGuardZones(SpokeBatch *batch) {
+  int lines = GeometryLines(batch->geometry);
+  int zones[GUARD_ZONES_MAX];
+  size_t count = 0;
+  bool alarm = false;
+
+  for (int z = 0; z < GUARD_ZONES_MAX; z++) {
     if (m_guard_zone[z]->m_type != GZ_OFF) {
-      m_guard_zone[z]->ProcessSpoke(angle, data, m_history[angle], len, range_meters);
+      zones[count++] = z;
     }
   }
 
-  if (m_multi_sweep_filter) {
-    for (size_t radius = 0; radius < len; radius++) {
-      if (!HISTORY_FILTER_ALLOW(m_history[angle][radius])) {
-        data[radius] = 0;
+  for (size_t s = 0; s < batch->count; s++) {
+    if (!batch->strong[s]) {
+      continue;
+    }
+    RadarSpoke *spoke = &batch->spokes[s];
+    size_t len = wxMin(spoke->len, GeometryReturns(batch->geometry));
+
+    // Guard zone bearings are always in LINES_PER_ROTATION units
+    SpokeBearing guard_angle = spoke->angle * LINES_PER_ROTATION / lines;
+    for (size_t z = 0; z < count; z++) {
+      GuardZone *zone = m_guard_zone[zones[z]];
+      int bogeys = zone->ProcessSpoke(guard_angle, spoke->data, batch->strong[s], batch->allow[s], len, batch->range_meters);
+      if (bogeys > m_pi->m_settings.guard_zone_threshold) {
+        GuardZoneEvent event = {zones[z], bogeys, MonotonicNanos()};
+        alarm |= m_guard_zone_events.Push(event);
       }
     }
   }
 
-  bool draw_trails_on_overlay = (m_pi->m_settings.trails_on_overlay == 1);
-  if (m_draw_overlay.draw && !draw_trails_on_overlay) {
-    m_draw_overlay.draw->ProcessRadarSpoke(m_pi->m_settings.overlay_transparency, bearing, data, len);
+  // Wake the GUI thread now instead of waiting for the next Notify(). One event is
+  // enough for everything that is queued until OnGuardZoneEvent() runs.
+  if (alarm && !__atomic_exchange_n(&m_guard_zone_event_posted, 1, __ATOMIC_ACQ_REL)) {
+    wxCommandEvent event(wxEVT_COMMAND_TEXT_UPDATED, GUARD_ZONE_EVENT_ID);
+    AddPendingEvent(event);
   }
+}
 
-  if (m_target_trails.value != 0) {
-    PolarToCartesianLookupTable *polarLookup;
-    polarLookup = GetPolarToCartesianLookupTable();
-    UpdateTrailPosition();
+/*
+ * Runs on the GUI thread. Sounds the alarm and shows the bogey dialog for the zones that
+ * StageGuardZones() found over the threshold, and records how long that took from the
+ * end of the zone sweep.
+ */
+void RadarInfo::OnGuardZoneEvent(wxCommandEvent &event) {
+  GuardZoneEvent alarms[GUARD_ZONE_EVENTS_SIZE];
+  size_t count = 0;
+
+  // Cleared before draining, so an alarm pushed after this posts a new event
+  __atomic_store_n(&m_guard_zone_event_posted, 0, __ATOMIC_RELEASE);
+  while (count < GUARD_ZONE_EVENTS_SIZE && m_guard_zone_events.Pop(&alarms[count])) {
+    count++;
+  }
+  if (count == 0) {
+    return;
+  }
+
+  if (m_pi->m_settings.show) {
+    m_pi->CheckGuardZoneBogeys();
+  }
+
+  uint64_t now = MonotonicNanos();
+  for (size_t i = 0; i < count; i++) {
+    int micros = (int)((now - alarms[i].sweep_nanos) / 1000);
+
+    LOG_GUARD(wxT("%s: zone %d alarm bogeys=%d latency=%d us"), m_name.c_str(), alarms[i].zone + 1, alarms[i].bogeys, micros);
+    m_statistics.guard_zone_alarms++;
+    m_statistics.guard_zone_alarm_micros = micros;
+    if (micros > m_statistics.guard_zone_alarm_max) {
+      m_statistics.guard_zone_alarm_max = micros;
+    }
+  }
+}
+
+void RadarInfo::StageMultiSweepFilter(SpokeBatch *batch) {
+  for (size_t s = 0; s < batch->count; s++) {
+    if (batch->allow[s]) {
+      HistoryApply(batch->spokes[s].data, wxMin(batch->spokes[s].len, GeometryReturns(batch->geometry)), batch->allow[s]);
+    }
+  }
+}
+
+// Encodes each spoke that has no spans yet, so the stages after it only visit the echoes.
+// The stages that use spans call it as well, so they still work when this stage is disabled.
+void RadarInfo::StageSpans(SpokeBatch *batch) {
+  size_t returns = GeometryReturns(batch->geometry);
+
+  for (size_t s = 0; s < batch->count; s++) {
+    RadarSpoke *spoke = &batch->spokes[s];
+    if (!spoke->spans) {
+      spoke->span_count = EncodeSpans(spoke->data, wxMin(spoke->len, returns), m_colour_map, m_spans[s]);
+      spoke->spans = m_spans[s];
+    }
+  }
+}
+
+// Added twice: before the trails and, when they are shown on the overlay, after them
+void RadarInfo::StageOverlay(SpokeBatch *batch) {
+  StageSpans(batch);
+  if (m_draw_overlay.geometry == batch->geometry) {
+    m_draw_overlay.draw->ProcessRadarSpokes(m_pi->m_settings.overlay_transparency, batch->spokes, batch->count);
+  }
+}
+
+// Colours the samples that are not a return with the age of the trails for MOTION, then
+// stamps the trail cells of the returns, which are the spans of echo colours. Only the
+// colouring visits every sample, and only the trails of MOTION; the colour is picked
+// without a branch. The spans are encoded again afterwards, as they now have trails.
+template <class G, int MOTION>
+void RadarInfo::StageTrails(SpokeBatch *batch) {
+  RadarSpokeStore<G> *store = GetStore<G>();
+  PolarToCartesianLookupTable<G> *polarLookup = GetPolarToCartesianLookupTable<G>();
+  uint8_t weakest_normal_blob = m_pi->m_settings.threshold_blue;
+
+  StageSpans(batch);
+  UpdateTrailPosition<G>();
+  TrueTrailGrid<G::TRAILS> *grid = &store->true_trails;
+  int origin_x = grid->origin_x + G::RETURNS;  // The ship is in the middle
+  int origin_y = grid->origin_y + G::RETURNS;
+
+  for (size_t s = 0; s < batch->count; s++) {
+    SpokeBearing angle = batch->spokes[s].angle;
+    SpokeBearing bearing = batch->spokes[s].bearing;
+    UINT8 *data = batch->spokes[s].data;
+    size_t len = wxMin(batch->spokes[s].len, (size_t)G::RETURNS);
+    const SpokeSpan *spans = batch->spokes[s].spans;
+    size_t span_count = batch->spokes[s].span_count;
+
+    store->TrailSpoke(angle);
+    TrailRotation now = store->trails_rotation;
+    TrailRotation *relative = store->relative_trails[angle];
 
     for (size_t radius = 0; radius < len; radius++) {
-      UINT8 *trail = &m_trails.true_trails[polarLookup->intx[bearing][radius] +
-                                           RETURNS_PER_LINE][polarLookup->inty[bearing][radius] + RETURNS_PER_LINE];
-      if (data[radius] >= weakest_normal_blob) {
-        *trail = 1;
+      TrailRotation stamp;
+      if (MOTION == TARGET_MOTION_TRUE) {
+        stamp = grid->cells[grid->Index(polarLookup->intx(bearing, radius) + origin_x,
+                                        polarLookup->inty(bearing, radius) + origin_y)];
       } else {
-        if (*trail > 0 && *trail < TRAIL_MAX_REVOLUTIONS) {
-          (*trail)++;
-        }
-        if (m_trails_motion.value == TARGET_MOTION_TRUE) {
-          data[radius] = m_trail_colour[*trail];
-        }
+        stamp = relative[radius];
       }
+      UINT8 colour = (UINT8)m_trail_colour[store->TrailAge(stamp)];
+      data[radius] = data[radius] >= weakest_normal_blob ? data[radius] : colour;
     }
 
-    UINT8 *trail = m_trails.relative_trails[angle];
-    for (size_t radius = 0; radius < len; radius++) {
-      if (data[radius] >= weakest_normal_blob) {
-        *trail = 1;
-      } else {
-        if (*trail > 0 && *trail < TRAIL_MAX_REVOLUTIONS) {
-          (*trail)++;
-        }
-        if (m_trails_motion.value == TARGET_MOTION_RELATIVE) {
-          data[radius] = m_trail_colour[*trail];
-        }
+    for (size_t i = 0; i < span_count; i++) {
+      if (spans[i].colour < BLOB_WEAK) {
+        continue;  // Sent as a trail colour, not a return
+      }
+      for (size_t radius = spans[i].start; radius < spans[i].end; radius++) {
+        grid->cells[grid->Index(polarLookup->intx(bearing, radius) + origin_x,
+                                polarLookup->inty(bearing, radius) + origin_y)] = now;
+        relative[radius] = now;
       }
-      trail++;
     }
+
+    batch->spokes[s].span_count = EncodeSpans(data, len, m_colour_map, m_spans[s]);
+    batch->spokes[s].spans = m_spans[s];
   }
+}
 
-  if (m_draw_overlay.draw && draw_trails_on_overlay) {
-    m_draw_overlay.draw->ProcessRadarSpoke(m_pi->m_settings.overlay_transparency, bearing, data, len);
+void RadarInfo::StagePanel(SpokeBatch *batch) {
+  StageSpans(batch);
+  if (m_draw_panel.geometry == batch->geometry) {
+    m_draw_panel.draw->ProcessRadarSpokes(3, batch->spokes, batch->count);
   }
+}
 
-  if (m_draw_panel.draw) {
-    m_draw_panel.draw->ProcessRadarSpoke(3, north_up ? bearing : angle, data, len);
+/*
+ * Fills a RadarFrame with the spokes as filtered, before the trails are painted into
+ * them, and publishes it when the spokes pass dead ahead. The angle of a spoke has half
+ * a rotation added for the OpenGL drawing, so line 0 of the frame is angle LINES / 2.
+ * A frame is only started at line 0, and dropped when the geometry or range changes
+ * halfway, so every published frame is one rotation at one range.
+ */
+template <class G>
+void RadarInfo::StageFrame(SpokeBatch *batch) {
+  for (size_t s = 0; s < batch->count; s++) {
+    RadarSpoke *spoke = &batch->spokes[s];
+    SpokeBearing line = G::Mod(spoke->angle - G::LINES / 2);
+    bool wrapped = false;
+
+    // A spoke more than half a rotation ahead is one that came late, it is stored but
+    // does not move the rotation on. Only a step forward over line 0 completes it.
+    if (G::Mod(line - m_frame_last_line) < G::LINES / 2) {
+      wrapped = line < m_frame_last_line;
+      m_frame_last_line = line;
+    }
+    if (m_frame && (m_frame->geometry != G::TYPE || m_frame->range_meters != batch->range_meters)) {
+      m_frame->Release();
+      m_frame = 0;
+    }
+    if (wrapped) {
+      if (m_frame) {
+        m_frame_pool.Publish(m_frame);
+      }
+      m_frame = m_frame_pool.Acquire(G::TYPE, batch->range_meters);
+    }
+    if (!m_frame) {
+      continue;
+    }
+
+    UINT8 *samples = m_frame->samples + line * G::RETURNS;
+    size_t len = wxMin(spoke->len, (size_t)G::RETURNS);
+    memcpy(samples, spoke->data, len);
+    memset(samples + len, 0, G::RETURNS - len);  // Beyond the returns that the spoke had
+    m_frame->heading[line] = G::Mod(spoke->bearing - spoke->angle);
+  }
+}
+
+// Keeps the spokes without the trails, for the resample when the range changes
+template <class G>
+void RadarInfo::StageRotation(SpokeBatch *batch) {
+  RadarSpokeStore<G> *store = GetStore<G>();
+  RadarRotation<G> *rotation = &store->rotation[store->rotation_current];
+
+  for (size_t s = 0; s < batch->count; s++) {
+    SpokeBearing angle = batch->spokes[s].angle;
+    size_t len = wxMin(batch->spokes[s].len, (size_t)G::RETURNS);
+
+    memcpy(rotation->data[angle], batch->spokes[s].data, len);
+    memset(rotation->data[angle] + len, 0, G::RETURNS - len);
+    rotation->bearing[angle] = batch->spokes[s].bearing;
+    rotation->range_meters[angle] = batch->range_meters;
   }
 }
 
+/*
+ * The range changed to range_meters: hand the rotation recorded so far to the resample
+ * thread and record the next one in the other buffer. When the thread is still busy
+ * with the previous change there is no placeholder this time.
+ *
+ * Caller holds m_exclusive
+ */
+template <class G>
+void RadarInfo::StartResample(int range_meters) {
+  RadarSpokeStore<G> *store = GetStore<G>();
+  RadarRotation<G> *last = &store->rotation[store->rotation_current];
+
+  if (m_resample_thread->Submit(G::TYPE, &last->data[0][0], last->bearing, last->range_meters, range_meters)) {
+    store->rotation_current ^= 1;
+  }
+  memset(store->rotation[store->rotation_current].range_meters, 0, sizeof(last->range_meters));
+}
+
+/*
+ * Called by the resample thread with lines of the last rotation resampled to range_meters.
+ * They are drawn on lines that have not been received since the range change, and are
+ * replaced when the spokes arrive. Returns false when the range or geometry has changed
+ * again, so the rest is no longer wanted.
+ */
+bool RadarInfo::ProcessPlaceholderSpokes(RadarGeometryType geometry, int range_meters, RadarSpoke *spokes, size_t count) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  if (geometry != m_geometry || range_meters != m_range_meters) {
+    return false;
+  }
+  count = wxMin(count, (size_t)SPOKE_BATCH_MAX);
+  for (size_t s = 0; s < count; s++) {
+    spokes[s].span_count = EncodeSpans(spokes[s].data, spokes[s].len, m_colour_map, m_spans[s]);
+    spokes[s].spans = m_spans[s];
+  }
+  if (m_draw_overlay.draw && m_draw_overlay.geometry == geometry) {
+    m_draw_overlay.draw->ProcessPlaceholderSpokes(m_pi->m_settings.overlay_transparency, spokes, count);
+  }
+  if (m_draw_panel.draw && m_draw_panel.geometry == geometry) {
+    m_draw_panel.draw->ProcessPlaceholderSpokes(3, spokes, count);
+  }
+  return true;
+}
+
+bool RadarInfo::AddSpokeStage(const wxString &name, SpokeStage *stage) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  return m_spoke_pipeline.Add(name, stage);
+}
+
+bool RadarInfo::EnableSpokeStage(const wxString &name, bool enable) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  return m_spoke_pipeline.Enable(name, enable);
+}
+
+bool RadarInfo::MoveSpokeStage(const wxString &name, size_t position) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  return m_spoke_pipeline.Move(name, position);
+}
+
+// One line per stage: name, average CPU time per spoke and spokes seen
+wxString RadarInfo::GetSpokeStageStatistics() {
+  wxCriticalSectionLocker lock(m_exclusive);
+  wxString t;
+
+  for (size_t i = 0; i < m_spoke_pipeline.GetStageCount(); i++) {
+    const SpokeStageEntry &e = m_spoke_pipeline.GetStage(i);
+    if (e.enabled && e.spokes > 0) {
+      t << wxString::Format(wxT("%s %.2f us/spoke\n"), e.name.c_str(), (double)e.cpu_nanos / 1000. / (double)e.spokes);
+    }
+  }
+  if (m_frame_pool.m_published > 0) {
+    t << wxString::Format(wxT("frames %lu dropped %lu\n"), m_frame_pool.m_published, m_frame_pool.m_dropped);
+  }
+  return t;
+}
+
 void RadarInfo::UpdateTransmitState() {
   time_t now = time(0);
 
@@ -599,7 +1147,11 @@ void RadarInfo::RequestRadarState(RadarState state) {
   }
 }
 
+// Caller holds m_exclusive
+template <class G>
 void RadarInfo::UpdateTrailPosition() {
+  RadarSpokeStore<G> *store = GetStore<G>();
+
   if (!m_pi->m_bpos_set || m_pi->m_heading_source == HEADING_NONE) {
     return;
   }
@@ -611,15 +1163,15 @@ void RadarInfo::UpdateTrailPosition() {
   double dif_lon = m_trails.lon - m_pi->m_ownship_lon;
   m_trails.lat = m_pi->m_ownship_lat;
   m_trails.lon = m_pi->m_ownship_lon;
-  double fshift_lat = dif_lat * 60. * 1852. / (double)m_range_meters * (double)(TRAILS_SIZE / 2);
-  double fshift_lon = dif_lon * 60. * 1852. / (double)m_range_meters * (double)(TRAILS_SIZE / 2);
+  double fshift_lat = dif_lat * 60. * 1852. / (double)m_range_meters * (double)(G::TRAILS / 2);
+  double fshift_lon = dif_lon * 60. * 1852. / (double)m_range_meters * (double)(G::TRAILS / 2);
   fshift_lon *= cos(deg2rad(m_pi->m_ownship_lat));  // at higher latitudes a degree of longitude is fewer meters
   int shift_lat = (int)(fshift_lat + m_trails.dif_lat);
   int shift_lon = (int)(fshift_lon + m_trails.dif_lon);
   m_trails.dif_lat = fshift_lat + m_trails.dif_lat - (double)shift_lat;  // save the rounding fraction and appy it next time
   m_trails.dif_lon = fshift_lon + m_trails.dif_lon - (double)shift_lon;
 
-  if (abs(shift_lat) >= TRAILS_SIZE || abs(shift_lon) >= TRAILS_SIZE) {  // huge shift, reset trails
+  if (abs(shift_lat) >= G::TRAILS || abs(shift_lon) >= G::TRAILS) {  // huge shift, reset trails
     ClearTrails();
     m_trails.lat = m_pi->m_ownship_lat;
     m_trails.lon = m_pi->m_ownship_lon;
@@ -628,27 +1180,7 @@ void RadarInfo::UpdateTrailPosition() {
     return;
   }
 
-  if (shift_lon > 0) {
-    for (int i = 0; i < TRAILS_SIZE; i++) {
-      memmove(&m_trails.true_trails[i][shift_lon], &m_trails.true_trails[i][0], TRAILS_SIZE - shift_lon);
-      memset(&m_trails.true_trails[i][0], 0, shift_lon);
-    }
-  }
-  if (shift_lon < 0) {
-    for (int i = 0; i < TRAILS_SIZE; i++) {
-      memmove(&m_trails.true_trails[i][0], &m_trails.true_trails[i][-shift_lon], TRAILS_SIZE + shift_lon);
-      memset(&m_trails.true_trails[i][TRAILS_SIZE + shift_lon], 0, -shift_lon);
-    }
-  }
-
-  if (shift_lat > 0) {
-    memmove(&m_trails.true_trails[shift_lat][0], &m_trails.true_trails[0][0], TRAILS_SIZE * (TRAILS_SIZE - shift_lat));
-    memset(&m_trails.true_trails[0][0], 0, TRAILS_SIZE * shift_lat);
-  }
-  if (shift_lat < 0) {
-    memmove(&m_trails.true_trails[0][0], &m_trails.true_trails[-shift_lat][0], TRAILS_SIZE * (TRAILS_SIZE + shift_lat));
-    memset(&m_trails.true_trails[TRAILS_SIZE + shift_lat][0], 0, -TRAILS_SIZE * shift_lat);
-  }
+  store->true_trails.Shift(shift_lat, shift_lon, store->trails_epoch);
 }
 
 void RadarInfo::RefreshDisplay(wxTimerEvent &event) {
@@ -693,8 +1225,20 @@ void RadarInfo::RenderGuardZone() {
   int start_bearing = 0, end_bearing = 0;
   GLubyte red = 0, green = 200, blue = 0, alpha = 50;
 
-  for (size_t z = 0; z < GUARD_ZONES; z++) {
-    if (m_guard_zone[z]->m_type != GZ_OFF) {
+  for (size_t z = 0; z < GUARD_ZONES_MAX; z++) {
+    if (m_guard_zone[z]->m_type == GZ_POLYGON) {
+      // Only the outline, a filled polygon need not be convex
+      if (m_pi->m_settings.guard_zone_render_style == 1) {
+        glColor4ub((GLubyte)255, (GLubyte)0, (GLubyte)0, (GLubyte)255);
+        glEnable(GL_LINE_STIPPLE);
+        glLineStipple(1, 0x000F);
+      } else {
+        glColor4ub(red, green, blue, (GLubyte)255);
+      }
+      glLineWidth(1.0);
+      m_guard_zone[z]->RenderPolygon();
+      glDisable(GL_LINE_STIPPLE);
+    } else if (m_guard_zone[z]->m_type != GZ_OFF) {
       if (m_guard_zone[z]->m_type == GZ_CIRCLE) {
         start_bearing = 0;
         end_bearing = 359;
@@ -825,7 +1369,7 @@ void RadarInfo::ResetRadarImage() {
   }
 }
 
-void RadarInfo::RenderRadarImage(DrawInfo *di) {
+void RadarInfo::RenderRadarImage(DrawInfo *di, bool north_up) {
   wxCriticalSectionLocker lock(m_exclusive);
   int drawing_method = m_pi->m_settings.drawing_method;
 
@@ -835,8 +1379,8 @@ void RadarInfo::RenderRadarImage(DrawInfo *di) {
   }
 
   // Determine if a new draw method is required
-  if (!di->draw || (drawing_method != di->drawing_method)) {
-    RadarDraw *newDraw = RadarDraw::make_Draw(this, drawing_method);
+  if (!di->draw || (drawing_method != di->drawing_method) || (m_geometry != di->geometry)) {
+    RadarDraw *newDraw = RadarDraw::make_Draw(this, drawing_method, m_geometry);
     if (!newDraw) {
       wxLogError(wxT("BR24radar_pi: out of memory"));
       return;
@@ -853,6 +1397,7 @@ void RadarInfo::RenderRadarImage(DrawInfo *di) {
       }
       di->draw = newDraw;
       di->drawing_method = drawing_method;
+      di->geometry = m_geometry;
     } else {
       m_pi->m_settings.drawing_method = 0;
       delete newDraw;
@@ -862,7 +1407,7 @@ void RadarInfo::RenderRadarImage(DrawInfo *di) {
     }
   }
 
-  di->draw->DrawRadarImage();
+  di->draw->DrawRadarImage(north_up);
   if (g_first_render) {
     g_first_render = false;
     wxLongLong startup_elapsed = wxGetUTCTimeMillis() - m_pi->m_boot_time;
@@ -896,7 +1441,7 @@ void RadarInfo::RenderRadarImage(wxPoint center, double scale, double rotate, bo
       RenderGuardZone();
       glPopMatrix();
     }
-    double radar_pixels_per_meter = ((double)RETURNS_PER_LINE) / m_range_meters;
+    double radar_pixels_per_meter = ((double)GeometryReturns(m_geometry)) / m_range_meters;
     scale = scale / radar_pixels_per_meter;
     glPushMatrix();
     glTranslated(center.x, center.y, 0);
@@ -905,7 +1450,7 @@ void RadarInfo::RenderRadarImage(wxPoint center, double scale, double rotate, bo
     }
     glScaled(scale, scale, 1.);
 
-    RenderRadarImage(&m_draw_overlay);
+    RenderRadarImage(&m_draw_overlay, true);
     if (m_overlay_refreshes_queued > 0) {
       m_overlay_refreshes_queued--;
     }
@@ -919,11 +1464,11 @@ void RadarInfo::RenderRadarImage(wxPoint center, double scale, double rotate, bo
 
     glPushMatrix();
     double overscan = (double)m_range_meters / (double)m_range.value;
-    scale = overscan / RETURNS_PER_LINE;
+    scale = overscan / GeometryReturns(m_geometry);
     glScaled(scale, scale, 1.);
     glRotated(rotate, 0.0, 0.0, 1.0);
     LOG_DIALOG(wxT("BR24radar_pi: %s render overscan=%g range=%d"), m_name.c_str(), overscan, m_range.value);
-    RenderRadarImage(&m_draw_panel);
+    RenderRadarImage(&m_draw_panel, IsDisplayNorthUp());
     if (m_refreshes_queued > 0) {
       m_refreshes_queued--;
     }
@@ -1151,7 +1696,13 @@ void RadarInfo::SetBearing(int bearing) {
   }
 }
 
-void RadarInfo::ClearTrails() { memset(&m_trails, 0, sizeof(m_trails)); }
+void RadarInfo::ClearTrails() {
+  memset(&m_trails, 0, sizeof(m_trails));
+  m_store_standard->ClearTrails();
+  if (m_store_hd) {
+    m_store_hd->ClearTrails();
+  }
+}
 
 void RadarInfo::ComputeTargetTrails() {
   static TrailRevolutionsAge maxRevs[TRAIL_ARRAY_SIZE] = {0,
@@ -33,6 +33,14 @@
 #define _RADAR_INFO_H_
 
 #include "br24radar_pi.h"
+#include "RadarGeometry.h"
+#include "SweepHistory.h"
+#include "TrueTrails.h"
+#include "CfarDetector.h"
+#include "SpokePipeline.h"
+#include "RadarResample.h"
+#include "GuardZoneAlarm.h"
+#include "RadarFrame.h"
 
 PLUGIN_BEGIN_NAMESPACE
 
@@ -114,14 +122,107 @@ class radar_range_control_item : public radar_control_item {
 struct DrawInfo {
   RadarDraw *draw;
   int drawing_method;
+  RadarGeometryType geometry;
   bool color_option;
 };
 
 typedef UINT8 TrailRevolutionsAge;
+
 #define SECONDS_TO_REVOLUTIONS(x) ((x)*2 / 5)
-#define TRAIL_MAX_REVOLUTIONS SECONDS_TO_REVOLUTIONS(600) + 1
+#define TRAIL_MAX_REVOLUTIONS (SECONDS_TO_REVOLUTIONS(600) + 1)
+#define TRAIL_REBASE_ROTATIONS (0x8000)  // Rotations after which old stamps are moved forward
+
+// One rotation of spokes as they were drawn, kept to resample when the range changes
+template <class G>
+struct RadarRotation {
+  UINT8 data[G::LINES][G::RETURNS];
+  SpokeBearing bearing[G::LINES];
+  int range_meters[G::LINES];  // Spoke range of data[line], 0 when it was not received at this range
+};
+
+// Multi sweep history, trails and last rotation of one radar, sized for the geometry of its spokes
+template <class G>
+struct RadarSpokeStore {
+  HistoryWord history[G::LINES][HISTORY_SWEEPS][HISTORY_WORDS(G::RETURNS)];
+  UINT8 history_newest[G::LINES];  // Plane in history[line] that holds the last sweep
+  // The trail cells hold the rotation in which they last had a return, so they are only
+  // written on a hit. A cell is empty when its stamp is not after trails_epoch.
+  TrueTrailGrid<G::TRAILS> true_trails;
+  TrailRotation relative_trails[G::LINES][G::RETURNS];
+  TrailRotation trails_rotation;  // Current rotation
+  TrailRotation trails_epoch;     // Stamps at or before this are empty cells
+  SpokeBearing trails_last_angle;
+  // rotation[rotation_current] is recorded from the spokes, the other one may be in use by
+  // the resample thread
+  RadarRotation<G> rotation[2];
+  int rotation_current;
+
+  RadarSpokeStore() {
+    ClearHistory();
+    memset(relative_trails, 0, sizeof(relative_trails));
+    trails_rotation = 1;
+    trails_epoch = 0;
+    trails_last_angle = 0;
+    memset(rotation[0].range_meters, 0, sizeof(rotation[0].range_meters));
+    memset(rotation[1].range_meters, 0, sizeof(rotation[1].range_meters));
+    rotation_current = 0;
+  }
+
+  void ClearHistory() {
+    memset(history, 0, sizeof(history));
+    memset(history_newest, 0, sizeof(history_newest));
+  }
+
+  // Empties all trail cells by moving the epoch past every stamp written so far
+  void ClearTrails() {
+    trails_epoch = trails_rotation;
+    trails_rotation++;
+  }
+
+  // Age of a trail cell in revolutions, 1 for a return in this rotation, 0 for an empty cell
+  TrailRevolutionsAge TrailAge(TrailRotation stamp) const {
+    TrailRotation since = (TrailRotation)(trails_rotation - stamp);
+
+    if (since >= (TrailRotation)(trails_rotation - trails_epoch)) {
+      return 0;
+    }
+    return (TrailRevolutionsAge)wxMin((unsigned)since + 1, (unsigned)(TRAIL_MAX_REVOLUTIONS));
+  }
+
+  // Called for every spoke; starts a new rotation when the angle wraps around
+  void TrailSpoke(SpokeBearing angle) {
+    if (angle + G::LINES / 2 < trails_last_angle) {
+      trails_rotation++;
+      if ((TrailRotation)(trails_rotation - trails_epoch) >= TRAIL_REBASE_ROTATIONS) {
+        RebaseTrails(true_trails.cells, G::TRAILS * G::TRAILS);
+        RebaseTrails(&relative_trails[0][0], G::LINES * G::RETURNS);
+        trails_epoch = (TrailRotation)(trails_rotation - TRAIL_MAX_REVOLUTIONS - 1);
+      }
+    }
+    trails_last_angle = angle;
+  }
+
+  // Keeps all stamps within TRAIL_REBASE_ROTATIONS of the current rotation, so that the
+  // 16 bit counter can wrap: empty cells get the new epoch and cells older than
+  // TRAIL_MAX_REVOLUTIONS, which all show the same, are moved up to that age.
+  void RebaseTrails(TrailRotation *cell, size_t count) {
+    TrailRotation live = (TrailRotation)(trails_rotation - trails_epoch);
+    TrailRotation oldest = (TrailRotation)(trails_rotation - TRAIL_MAX_REVOLUTIONS);
+
+    for (size_t i = 0; i < count; i++) {
+      TrailRotation since = (TrailRotation)(trails_rotation - cell[i]);
+      if (since >= live) {
+        cell[i] = (TrailRotation)(oldest - 1);
+      } else if (since > TRAIL_MAX_REVOLUTIONS) {
+        cell[i] = oldest;
+      }
+    }
+  }
+};
 enum { TRAIL_OFF, TRAIL_15SEC, TRAIL_30SEC, TRAIL_1MIN, TRAIL_3MIN, TRAIL_10MIN, TRAIL_CONTINUOUS, TRAIL_ARRAY_SIZE };
 
+class RadarInfoStage;
+
 class RadarInfo : public wxEvtHandler {
  public:
   wxString m_name;  // Either "Radar", "Radar A", "Radar B".
@@ -186,21 +287,14 @@ class RadarInfo : public wxEvtHandler {
   int m_refresh_millis;
   int m_main_timer_timeout;
 
-  GuardZone *m_guard_zone[GUARD_ZONES];
+  GuardZone *m_guard_zone[GUARD_ZONES_MAX];  // The first GUARD_ZONES can be edited in the control dialog
   double m_ebl[BEARING_LINES];
   double m_vrm[BEARING_LINES];
   receive_statistics m_statistics;
 
   bool m_multi_sweep_filter;
-  UINT8 m_history[LINES_PER_ROTATION][RETURNS_PER_LINE];
-#define HISTORY_FILTER_ALLOW(x) (HasBitCount2[(x)&7])
-
-#define TRAILS_SIZE (RETURNS_PER_LINE * 2)
-#define TRAILS_MIDDLE (TRAILS_SIZE / 2)
 
   struct TrailBuffer {
-    TrailRevolutionsAge true_trails[TRAILS_SIZE][TRAILS_SIZE];
-    TrailRevolutionsAge relative_trails[LINES_PER_ROTATION][RETURNS_PER_LINE];
     double lat;
     double lon;
     double dif_lat;  // Fraction of a pixel expressed in lat/lon for True Motion Target Trails
@@ -220,8 +314,10 @@ class RadarInfo : public wxEvtHandler {
   void SetAutoRangeMeters(int meters);
   bool SetControlValue(ControlType controlType, int value);
   void ProcessRadarSpoke(SpokeBearing angle, SpokeBearing bearing, UINT8 *data, size_t len, int range_meters);
+  void ProcessRadarSpokes(RadarGeometryType geometry, RadarSpoke *spokes, size_t count, int range_meters);
+  bool ProcessPlaceholderSpokes(RadarGeometryType geometry, int range_meters, RadarSpoke *spokes, size_t count);
   void RefreshDisplay(wxTimerEvent &event);
-  void UpdateTrailPosition();
+  void OnGuardZoneEvent(wxCommandEvent &event);
   void RenderGuardZone();
   void ResetRadarImage();
   void RenderRadarImage(wxPoint center, double scale, double rotation, bool overlay);
@@ -245,6 +341,19 @@ class RadarInfo : public wxEvtHandler {
   void SetMouseVrmEbl(double vrm, double ebl);
   void SetBearing(int bearing);
   void ClearTrails();
+  RadarGeometryType GetGeometry() { return m_geometry; }
+
+  // Stages of the spoke processing, see SpokePipeline.h. Added stages run after the standard ones.
+  bool AddSpokeStage(const wxString &name, SpokeStage *stage);
+  bool EnableSpokeStage(const wxString &name, bool enable);
+  bool MoveSpokeStage(const wxString &name, size_t position);
+  wxString GetSpokeStageStatistics();
+
+  // Complete rotations, see RadarFrame.h. Frames are only assembled while there is a
+  // reader. GetFrame() returns the latest with a reference that the caller must Release().
+  void AddFrameReader() { __atomic_add_fetch(&m_frame_readers, 1, __ATOMIC_RELAXED); }
+  void RemoveFrameReader() { __atomic_sub_fetch(&m_frame_readers, 1, __ATOMIC_RELAXED); }
+  RadarFrame *GetFrame() { return m_frame_pool.GetLatest(); }
   bool IsDisplayNorthUp() { return m_orientation.value == ORIENTATION_NORTH_UP && m_pi->m_heading_source != HEADING_NONE; }
 
   wxString GetCanvasTextTopLeft();
@@ -259,7 +368,33 @@ class RadarInfo : public wxEvtHandler {
 
  private:
   void ResetSpokes();
-  void RenderRadarImage(DrawInfo *di);
+  template <class G>
+  RadarSpokeStore<G> *GetStore();
+  template <class G>
+  void ProcessSpokes(RadarSpoke *spokes, size_t count, int range_meters);
+  template <class G>
+  void UpdateTrailPosition();
+
+  unsigned GetSpokeFeatures();
+  void SelectSpokeKernels(unsigned features);
+  void StageMainBang(SpokeBatch *batch);
+  void StageCfar(SpokeBatch *batch);
+  template <class G, bool FILTER>
+  void StageHistory(SpokeBatch *batch);
+  void StageGuardZones(SpokeBatch *batch);
+  void StageMultiSweepFilter(SpokeBatch *batch);
+  void StageSpans(SpokeBatch *batch);
+  void StageOverlay(SpokeBatch *batch);
+  template <class G, int MOTION>
+  void StageTrails(SpokeBatch *batch);
+  void StagePanel(SpokeBatch *batch);
+  template <class G>
+  void StageRotation(SpokeBatch *batch);
+  template <class G>
+  void StageFrame(SpokeBatch *batch);
+  template <class G>
+  void StartResample(int range_meters);
+  void RenderRadarImage(DrawInfo *di, bool north_up);
   wxString FormatDistance(double distance);
   wxString FormatAngle(double angle);
 
@@ -268,10 +403,35 @@ class RadarInfo : public wxEvtHandler {
   int m_previous_auto_range_meters;
   int m_auto_range_meters;
 
-  wxCriticalSection m_exclusive;  // protects the following two
+  wxCriticalSection m_exclusive;  // protects the following
   DrawInfo m_draw_panel;          // Draw onto our own panel
   DrawInfo m_draw_overlay;        // Abstract painting method
 
+  RadarGeometryType m_geometry;                         // Geometry of the last received spokes
+  RadarSpokeStore<GeometryStandard> *m_store_standard;  // Always allocated
+  RadarSpokeStore<GeometryHD> *m_store_hd;              // Allocated when the first HD spoke arrives
+
+  SpokePipeline m_spoke_pipeline;
+  RadarInfoStage *m_history_stage;  // Owned by m_spoke_pipeline, kernel picked by SelectSpokeKernels()
+  RadarInfoStage *m_trails_stage;   // Same
+  unsigned m_spoke_features;        // SpokeFeature bits the stages were last selected for
+  RadarResampleThread *m_resample_thread;
+  GuardZoneEventQueue m_guard_zone_events;  // Filled by StageGuardZones(), drained by OnGuardZoneEvent()
+  int m_guard_zone_event_posted;            // An OnGuardZoneEvent() is pending
+  // Prefix sums of the last two spokes for StageCfar(), m_cfar_sums[m_cfar_current] is the newest
+  uint32_t m_cfar_sums[2][MAX_GEOMETRY_RETURNS + 1];
+  int m_cfar_current;
+  RadarGeometryType m_cfar_geometry;  // Of the newest sums
+  SpokeBearing m_cfar_angle;
+  size_t m_cfar_len;  // 0 when there are no sums
+  HistoryWord m_cfar_detect[HISTORY_WORDS(MAX_GEOMETRY_RETURNS)];
+  RadarFramePool m_frame_pool;
+  RadarFrame *m_frame;            // Being filled by StageFrame(), 0 until the next pass through north
+  SpokeBearing m_frame_last_line;  // Of the last spoke that moved the rotation on, 0 is dead ahead
+  int m_frame_readers;
+  HistoryWord m_allow[SPOKE_BATCH_MAX][HISTORY_WORDS(MAX_GEOMETRY_RETURNS)];  // M-of-N filter of each spoke in the batch
+  SpokeSpan m_spans[SPOKE_BATCH_MAX][SPOKE_SPANS_MAX(MAX_GEOMETRY_RETURNS)];   // Spans of each spoke in the batch
+
   int m_verbose;
   wxTimer *m_timer;
 
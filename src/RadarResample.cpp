@@ -0,0 +1,150 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "br24radar_pi.h"
+#include "RadarResample.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#undef M_SETTINGS
+#define M_SETTINGS m_ri->m_pi->m_settings
+
+void ResampleTable(int from_meters, int to_meters, size_t returns, UINT16 *first) {
+  for (size_t r = 0; r <= returns; r++) {
+    // Sample r at the new range starts at this sample at the old range
+    uint64_t start = (uint64_t)r * (uint64_t)to_meters / (uint64_t)from_meters;
+    first[r] = (UINT16)(start < returns ? start : returns);
+  }
+}
+
+void ResampleLine(const UINT8 *in, size_t in_len, UINT8 *out, size_t out_len, const UINT16 *first) {
+  for (size_t r = 0; r < out_len; r++) {
+    size_t begin = first[r];
+    size_t end = wxMax((size_t)first[r + 1], begin + 1);
+    UINT8 strongest = 0;
+
+    for (size_t i = begin; i < end && i < in_len; i++) {
+      strongest = wxMax(strongest, in[i]);
+    }
+    out[r] = strongest;
+  }
+}
+
+RadarResampleThread::RadarResampleThread(RadarInfo *ri) : wxThread(wxTHREAD_JOINABLE), m_ri(ri), m_quit(false), m_busy(false) {
+  m_out = (UINT8 *)malloc(MAX_GEOMETRY_LINES * MAX_GEOMETRY_RETURNS);
+  Create(64 * 1024);
+}
+
+RadarResampleThread::~RadarResampleThread() { free(m_out); }
+
+void RadarResampleThread::Shutdown() {
+  m_quit = true;
+  m_wakeup.Post();
+}
+
+bool RadarResampleThread::Submit(RadarGeometryType geometry, const UINT8 *data, const SpokeBearing *bearing,
+                                 const int *range_meters, int to_meters) {
+  wxCriticalSectionLocker lock(m_job_lock);
+
+  if (m_busy || !m_out) {
+    return false;
+  }
+  m_geometry = geometry;
+  m_data = data;
+  m_bearing = bearing;
+  m_range_meters = range_meters;
+  m_to_meters = to_meters;
+  m_busy = true;
+  m_wakeup.Post();
+  return true;
+}
+
+void *RadarResampleThread::Entry() {
+  while (!m_quit) {
+    m_wakeup.WaitTimeout(1000);
+
+    bool busy;
+    {
+      wxCriticalSectionLocker lock(m_job_lock);
+      busy = m_busy;
+    }
+    if (busy && !m_quit) {
+      Resample();
+      wxCriticalSectionLocker lock(m_job_lock);
+      m_busy = false;
+    }
+  }
+  return 0;
+}
+
+void RadarResampleThread::Resample() {
+  uint64_t start = ThreadCpuNanos();
+  int lines = GeometryLines(m_geometry);
+  size_t returns = GeometryReturns(m_geometry);
+  int table_meters = 0;
+  RadarSpoke spokes[SPOKE_BATCH_MAX];
+  size_t count = 0;
+
+  for (int line = 0; line < lines && !m_quit; line++) {
+    int from_meters = m_range_meters[line];
+    if (from_meters <= 0) {
+      continue;  // Not received since the previous range change
+    }
+    if (from_meters != table_meters) {
+      ResampleTable(from_meters, m_to_meters, returns, m_first);
+      table_meters = from_meters;
+    }
+
+    UINT8 *out = m_out + line * returns;
+    ResampleLine(m_data + line * returns, returns, out, returns, m_first);
+    spokes[count].angle = line;
+    spokes[count].bearing = m_bearing[line];
+    spokes[count].data = out;
+    spokes[count].len = returns;
+    count++;
+
+    // Handed over in batches, so the receive thread is not kept out of RadarInfo for long
+    if (count == SPOKE_BATCH_MAX) {
+      if (!m_ri->ProcessPlaceholderSpokes(m_geometry, m_to_meters, spokes, count)) {
+        return;  // The range or geometry changed again
+      }
+      count = 0;
+    }
+  }
+  if (count > 0) {
+    m_ri->ProcessPlaceholderSpokes(m_geometry, m_to_meters, spokes, count);
+  }
+
+  LOG_VERBOSE(wxT("BR24radar_pi: %s resampled last rotation to %d meters in %d us"), m_ri->m_name.c_str(), m_to_meters,
+              (int)((ThreadCpuNanos() - start) / 1000));
+}
+
+PLUGIN_END_NAMESPACE
@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _RADAR_RESAMPLE_H_
+#define _RADAR_RESAMPLE_H_
+
+#include "br24radar_pi.h"
+#include "RadarGeometry.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+// out[r] = strongest of in[first[r] .. first[r + 1] - 1], or of in[first[r]] when that is
+// empty; 0 where first[r] >= in_len. first[] has out_len + 1 entries.
+extern void ResampleLine(const UINT8 *in, size_t in_len, UINT8 *out, size_t out_len, const UINT16 *first);
+
+// first[] for ResampleLine() when the spoke is resampled from from_meters to to_meters
+extern void ResampleTable(int from_meters, int to_meters, size_t returns, UINT16 *first);
+
+/*
+ * Turns the last rotation before a range change into a placeholder image at the new
+ * range, so the screen does not go blank until the radar has sent a full rotation at
+ * the new range. Zooming out shrinks the image, keeping the strongest return of the
+ * samples that merge; zooming in crops and stretches it.
+ *
+ * The work is done on this thread. The lines are then handed to
+ * RadarInfo::ProcessPlaceholderSpokes(), which only draws those that no spoke at the
+ * new range has reached yet.
+ */
+class RadarResampleThread : public wxThread {
+ public:
+  RadarResampleThread(RadarInfo *ri);
+  ~RadarResampleThread();
+
+  void *Entry();
+  void Shutdown();
+
+  // Start resampling a rotation of lines x returns spokes. The arrays are only read, and
+  // must not change until IsBusy() returns false. Returns false when still busy.
+  bool Submit(RadarGeometryType geometry, const UINT8 *data, const SpokeBearing *bearing, const int *range_meters,
+              int to_meters);
+  bool IsBusy() {
+    wxCriticalSectionLocker lock(m_job_lock);
+    return m_busy;
+  }
+
+ private:
+  void Resample();
+
+  RadarInfo *m_ri;
+  wxSemaphore m_wakeup;
+  volatile bool m_quit;
+
+  wxCriticalSection m_job_lock;  // protects m_busy and the job
+  bool m_busy;
+  RadarGeometryType m_geometry;
+  const UINT8 *m_data;
+  const SpokeBearing *m_bearing;
+  const int *m_range_meters;
+  int m_to_meters;
+
+  UINT8 *m_out;  // MAX_GEOMETRY_LINES * MAX_GEOMETRY_RETURNS
+  UINT16 m_first[MAX_GEOMETRY_RETURNS + 1];
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RADAR_RESAMPLE_H_ */
@@ -0,0 +1,173 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "br24radar_pi.h"
+#include "SpokePipeline.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+uint64_t ThreadCpuNanos() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  struct timespec ts;
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+  return (uint64_t)wxGetLocalTimeMillis().GetValue() * 1000000;
+#endif
+}
+
+uint64_t MonotonicNanos() {
+#ifdef CLOCK_MONOTONIC
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+  return (uint64_t)wxGetLocalTimeMillis().GetValue() * 1000000;
+#endif
+}
+
+size_t EncodeSpans(const UINT8 *data, size_t len, const BlobColour *colour_map, SpokeSpan *spans) {
+  size_t count = 0;
+  size_t r = 0;
+
+  while (r < len) {
+    BlobColour colour = colour_map[data[r]];
+    if (colour == BLOB_NONE) {
+      r++;
+      continue;
+    }
+    size_t start = r;
+    while (++r < len && colour_map[data[r]] == colour) {
+    }
+    spans[count].start = (UINT16)start;
+    spans[count].end = (UINT16)r;
+    spans[count].colour = (UINT8)colour;
+    count++;
+  }
+  return count;
+}
+
+SpokePipeline::SpokePipeline() { m_count = 0; }
+
+SpokePipeline::~SpokePipeline() {
+  for (size_t i = 0; i < m_count; i++) {
+    delete m_stage[i].stage;
+  }
+}
+
+int SpokePipeline::Find(const wxString &name) const {
+  for (size_t i = 0; i < m_count; i++) {
+    if (m_stage[i].name == name) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
+
+bool SpokePipeline::Add(const wxString &name, SpokeStage *stage) {
+  if (m_count == SPOKE_STAGES_MAX || Find(name) >= 0) {
+    wxLogError(wxT("BR24radar_pi: cannot add spoke stage %s"), name.c_str());
+    delete stage;
+    return false;
+  }
+
+  SpokeStageEntry *e = &m_stage[m_count++];
+  e->name = name;
+  e->stage = stage;
+  e->enabled = true;
+  e->active = true;
+  e->cpu_nanos = 0;
+  e->spokes = 0;
+  return true;
+}
+
+bool SpokePipeline::Enable(const wxString &name, bool enable) {
+  int i = Find(name);
+
+  if (i < 0) {
+    return false;
+  }
+  m_stage[i].enabled = enable;
+  return true;
+}
+
+bool SpokePipeline::SetActive(const wxString &name, bool active) {
+  int i = Find(name);
+
+  if (i < 0) {
+    return false;
+  }
+  m_stage[i].active = active;
+  return true;
+}
+
+bool SpokePipeline::Move(const wxString &name, size_t position) {
+  int i = Find(name);
+
+  if (i < 0 || position >= m_count) {
+    return false;
+  }
+
+  SpokeStageEntry moved = m_stage[i];
+  for (; (size_t)i < position; i++) {
+    m_stage[i] = m_stage[i + 1];
+  }
+  for (; (size_t)i > position; i--) {
+    m_stage[i] = m_stage[i - 1];
+  }
+  m_stage[position] = moved;
+  return true;
+}
+
+void SpokePipeline::Process(SpokeBatch *batch) {
+  for (size_t s = 0; s < batch->count; s++) {
+    batch->strong[s] = 0;
+    batch->allow[s] = 0;
+    batch->spokes[s].spans = 0;
+    batch->spokes[s].span_count = 0;
+  }
+
+  uint64_t start = ThreadCpuNanos();
+  for (size_t i = 0; i < m_count; i++) {
+    SpokeStageEntry *e = &m_stage[i];
+    if (e->enabled && e->active) {
+      e->stage->Process(batch);
+      uint64_t end = ThreadCpuNanos();
+      e->cpu_nanos += end - start;
+      e->spokes += batch->count;
+      start = end;
+    }
+  }
+}
+
+PLUGIN_END_NAMESPACE
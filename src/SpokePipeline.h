@@ -0,0 +1,119 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _SPOKE_PIPELINE_H_
+#define _SPOKE_PIPELINE_H_
+
+#include "RadarGeometry.h"
+#include "SweepHistory.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define SPOKE_BATCH_MAX (32)   // Most spokes that go through the pipeline at once
+#define SPOKE_STAGES_MAX (16)  // Most stages in one pipeline
+
+// Spans that a spoke of RETURNS samples can have at most, when every sample differs from the last
+#define SPOKE_SPANS_MAX(RETURNS) (RETURNS)
+
+// CPU time of the calling thread in nanoseconds where the platform has it, wall time otherwise
+extern uint64_t ThreadCpuNanos();
+
+// Monotonic wall time in nanoseconds where the platform has it, local time otherwise
+extern uint64_t MonotonicNanos();
+
+// Splits data into runs of the same colour_map[] colour, leaving out BLOB_NONE. spans has
+// room for SPOKE_SPANS_MAX(len). Returns the number of spans.
+extern size_t EncodeSpans(const UINT8 *data, size_t len, const BlobColour *colour_map, SpokeSpan *spans);
+
+/*
+ * The spokes of one batch as they go from stage to stage. All spokes have the same
+ * geometry. A stage may change the spoke data in place and may fill in the fields
+ * below for the stages after it.
+ */
+struct SpokeBatch {
+  RadarGeometryType geometry;
+  RadarSpoke *spokes;
+  size_t count;
+  int range_meters;
+
+  // Set by the history stage, null when it has not run
+  const HistoryWord *strong[SPOKE_BATCH_MAX];  // Returns of this sweep that are a blob
+  const HistoryWord *allow[SPOKE_BATCH_MAX];   // Returns passed by the M-of-N filter
+};
+
+/*
+ * One step of the spoke processing. Implementations are registered with a pipeline,
+ * which owns them from then on.
+ */
+class SpokeStage {
+ public:
+  virtual ~SpokeStage() {}
+  virtual void Process(SpokeBatch *batch) = 0;
+};
+
+struct SpokeStageEntry {
+  wxString name;
+  SpokeStage *stage;
+  bool enabled;        // Set by the user of the pipeline
+  bool active;         // Cleared by the owner while the settings give the stage nothing to do
+  uint64_t cpu_nanos;  // CPU time spent in Process() since the stage was added
+  uint64_t spokes;     // Spokes that went through Process()
+};
+
+/*
+ * Runs the enabled and active stages in order over each batch and keeps the time and
+ * spoke count of each. It does no locking of its own; RadarInfo calls it with m_exclusive
+ * held.
+ */
+class SpokePipeline {
+ public:
+  SpokePipeline();
+  ~SpokePipeline();
+
+  bool Add(const wxString &name, SpokeStage *stage);  // Append; false (and stage deleted) when full
+  bool Enable(const wxString &name, bool enable);
+  bool SetActive(const wxString &name, bool active);
+  bool Move(const wxString &name, size_t position);  // Shifts the stages in between
+  void Process(SpokeBatch *batch);
+
+  size_t GetStageCount() const { return m_count; }
+  const SpokeStageEntry &GetStage(size_t i) const { return m_stage[i]; }
+
+ private:
+  int Find(const wxString &name) const;
+
+  SpokeStageEntry m_stage[SPOKE_STAGES_MAX];
+  size_t m_count;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _SPOKE_PIPELINE_H_ */
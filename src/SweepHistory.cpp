@@ -0,0 +1,171 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#include "SweepHistory.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SWEEP_HISTORY_SSE2
+#include <emmintrin.h>
+#endif
+
+static inline size_t PopCount(HistoryWord w) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(w);
+#else
+  w = w - ((w >> 1) & 0x5555555555555555ULL);
+  w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+  w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return (size_t)((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+void HistoryThreshold(const uint8_t *data, size_t len, uint8_t threshold, HistoryWord *mask) {
+  size_t full = len / HISTORY_WORD_BITS;
+  size_t w;
+
+#ifdef SWEEP_HISTORY_SSE2
+  // Unsigned x >= t is max(x, t) == x; movemask then gives 16 bits at a time
+  const __m128i t = _mm_set1_epi8((char)threshold);
+  for (w = 0; w < full; w++) {
+    const uint8_t *d = data + w * HISTORY_WORD_BITS;
+    HistoryWord bits = 0;
+    for (int q = 0; q < HISTORY_WORD_BITS / 16; q++) {
+      __m128i x = _mm_loadu_si128((const __m128i *)(d + q * 16));
+      __m128i ge = _mm_cmpeq_epi8(_mm_max_epu8(x, t), x);
+      bits |= (HistoryWord)(uint16_t)_mm_movemask_epi8(ge) << (q * 16);
+    }
+    mask[w] = bits;
+  }
+#else
+  for (w = 0; w < full; w++) {
+    const uint8_t *d = data + w * HISTORY_WORD_BITS;
+    HistoryWord bits = 0;
+    for (int b = 0; b < HISTORY_WORD_BITS; b++) {
+      bits |= (HistoryWord)(d[b] >= threshold) << b;
+    }
+    mask[w] = bits;
+  }
+#endif
+
+  if (full * HISTORY_WORD_BITS < len) {
+    const uint8_t *d = data + full * HISTORY_WORD_BITS;
+    HistoryWord bits = 0;
+    for (size_t b = 0; b < len - full * HISTORY_WORD_BITS; b++) {
+      bits |= (HistoryWord)(d[b] >= threshold) << b;
+    }
+    mask[full] = bits;
+  }
+}
+
+void HistoryFilter(const HistoryWord *planes, size_t words, unsigned newest, unsigned n, unsigned m, HistoryWord *allow) {
+  // count >= m exactly when count + (16 - m) carries out of a 4 bit counter
+  const unsigned add = 16 - m;
+
+  for (size_t w = 0; w < words; w++) {
+    HistoryWord c0 = 0, c1 = 0, c2 = 0, c3 = 0;  // Bit sliced count of set planes, 0..8
+
+    for (unsigned k = 0; k < n; k++) {
+      HistoryWord p = planes[((newest - k) & (HISTORY_SWEEPS - 1)) * words + w];
+      HistoryWord t;
+
+      t = c0 & p;
+      c0 ^= p;
+      p = t;
+      t = c1 & p;
+      c1 ^= p;
+      p = t;
+      t = c2 & p;
+      c2 ^= p;
+      c3 |= t;
+    }
+
+    HistoryWord carry = 0;
+    carry = (add & 1) ? (c0 | carry) : (c0 & carry);
+    carry = (add & 2) ? (c1 | carry) : (c1 & carry);
+    carry = (add & 4) ? (c2 | carry) : (c2 & carry);
+    carry = (add & 8) ? (c3 | carry) : (c3 & carry);
+    allow[w] = carry;
+  }
+}
+
+void HistoryApply(uint8_t *data, size_t len, const HistoryWord *allow) {
+  for (size_t w = 0; w < HISTORY_WORDS(len); w++) {
+    HistoryWord a = allow[w];
+    if (a == ~(HistoryWord)0) {
+      continue;
+    }
+    uint8_t *d = data + w * HISTORY_WORD_BITS;
+    size_t bits = len - w * HISTORY_WORD_BITS;
+    if (bits > HISTORY_WORD_BITS) {
+      bits = HISTORY_WORD_BITS;
+    }
+    for (size_t b = 0; b < bits; b++) {
+      d[b] &= (uint8_t)-(uint8_t)((a >> b) & 1);
+    }
+  }
+}
+
+size_t HistoryCount(const HistoryWord *mask, const HistoryWord *filter, size_t first, size_t last) {
+  size_t count = 0;
+
+  if (first > last) {
+    return 0;
+  }
+  for (size_t w = first / HISTORY_WORD_BITS; w <= last / HISTORY_WORD_BITS; w++) {
+    HistoryWord bits = mask[w];
+    if (filter) {
+      bits &= filter[w];
+    }
+    if (w == first / HISTORY_WORD_BITS) {
+      bits &= ~(HistoryWord)0 << (first % HISTORY_WORD_BITS);
+    }
+    if (w == last / HISTORY_WORD_BITS) {
+      bits &= ~(HistoryWord)0 >> (HISTORY_WORD_BITS - 1 - last % HISTORY_WORD_BITS);
+    }
+    count += PopCount(bits);
+  }
+  return count;
+}
+
+size_t HistoryCountMask(const HistoryWord *mask, const HistoryWord *filter, const HistoryWord *zone, size_t words) {
+  size_t count = 0;
+
+  if (filter) {
+    for (size_t w = 0; w < words; w++) {
+      count += PopCount(mask[w] & filter[w] & zone[w]);
+    }
+  } else {
+    for (size_t w = 0; w < words; w++) {
+      count += PopCount(mask[w] & zone[w]);
+    }
+  }
+  return count;
+}
@@ -0,0 +1,74 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _SWEEP_HISTORY_H_
+#define _SWEEP_HISTORY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Multi sweep history as bit planes. For every line the last HISTORY_SWEEPS sweeps
+ * are kept as one bit per return: set when the return was at least as strong as the
+ * weakest normal blob. The planes of a line form a ring, the newest one is
+ * overwritten by the next sweep of that line.
+ *
+ * The M-of-N filter allows a return when it was set in at least M of the last N
+ * sweeps; this is worked out for 64 returns at a time.
+ */
+
+typedef uint64_t HistoryWord;
+
+#define HISTORY_SWEEPS (8)                                   // Must be a power of 2, at most 8
+#define HISTORY_WORD_BITS (64)
+#define HISTORY_WORDS(returns) (((returns) + HISTORY_WORD_BITS - 1) / HISTORY_WORD_BITS)
+
+#define DEFAULT_MULTI_SWEEP_FILTER_M (2)
+#define DEFAULT_MULTI_SWEEP_FILTER_N (3)
+
+// Set bit r of mask[] when data[r] >= threshold, for r < len. Bits beyond len are cleared.
+extern void HistoryThreshold(const uint8_t *data, size_t len, uint8_t threshold, HistoryWord *mask);
+
+// allow[] = returns set in at least m of the n newest planes. planes[] holds HISTORY_SWEEPS
+// planes of 'words' words each, plane 'newest' being the last sweep. 1 <= m <= n <= HISTORY_SWEEPS.
+extern void HistoryFilter(const HistoryWord *planes, size_t words, unsigned newest, unsigned n, unsigned m,
+                          HistoryWord *allow);
+
+// Zero data[r] for every r < len that is not set in allow[].
+extern void HistoryApply(uint8_t *data, size_t len, const HistoryWord *allow);
+
+// Number of bits set in mask[] (and in filter[], when not null) from bit first up to and including bit last.
+extern size_t HistoryCount(const HistoryWord *mask, const HistoryWord *filter, size_t first, size_t last);
+
+// Number of bits set in both mask[] and zone[] (and in filter[], when not null) in the first 'words' words.
+extern size_t HistoryCountMask(const HistoryWord *mask, const HistoryWord *filter, const HistoryWord *zone, size_t words);
+
+#endif /* _SWEEP_HISTORY_H_ */
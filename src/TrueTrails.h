@@ -0,0 +1,105 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+#ifndef _TRUE_TRAILS_H_
+#define _TRUE_TRAILS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Rotation in which a trail cell last had a return
+typedef uint16_t TrailRotation;
+
+/*
+ * The true motion trails image, TRAILS by TRAILS cells around the ship. It is a torus:
+ * the cell for (x, y) relative to the trails origin is at Index(x + origin_x, y + origin_y).
+ * Moving the ship moves the origin instead of the cells, see Shift(). The cells are in
+ * Z order (the bits of x and y interleaved), so a spoke at any bearing and its
+ * neighbours mostly stay within the same cache lines.
+ *
+ * TRAILS must be a power of 2, at most 65536.
+ */
+template <int TRAILS>
+struct TrueTrailGrid {
+  static const int MASK = TRAILS - 1;
+
+  TrailRotation cells[TRAILS * TRAILS];
+  uint32_t index_x[TRAILS];  // x bits spread out to the odd bits of the index
+  uint32_t index_y[TRAILS];  // y bits spread out to the even bits of the index
+  int origin_x;
+  int origin_y;
+
+  TrueTrailGrid() {
+    for (int i = 0; i < TRAILS; i++) {
+      uint32_t spread = 0;
+      for (int bit = 0; (1 << bit) < TRAILS; bit++) {
+        spread |= (uint32_t)((i >> bit) & 1) << (2 * bit);
+      }
+      index_x[i] = spread << 1;
+      index_y[i] = spread;
+    }
+    for (size_t i = 0; i < (size_t)TRAILS * TRAILS; i++) {
+      cells[i] = 0;
+    }
+    origin_x = 0;
+    origin_y = 0;
+  }
+
+  size_t Index(int x, int y) const { return index_x[x & MASK] | index_y[y & MASK]; }
+
+  // Sets the nx by ny cells from index (x, y) on to empty, wrapping around the torus
+  void Empty(int x, int nx, int y, int ny, TrailRotation empty) {
+    for (int i = 0; i < nx; i++) {
+      for (int j = 0; j < ny; j++) {
+        cells[Index(x + i, y + j)] = empty;
+      }
+    }
+  }
+
+  // Moves every cell by (shift_x, shift_y), |shift| < TRAILS, by moving the origin the
+  // other way. The rows and columns that wrap around to the other side are the ones
+  // that come into view, so only those are set to empty.
+  void Shift(int shift_x, int shift_y, TrailRotation empty) {
+    if (shift_y != 0) {
+      origin_y = (origin_y - shift_y) & MASK;
+      int exposed = (shift_y > 0 ? 0 : TRAILS + shift_y) + origin_y;
+      Empty(0, TRAILS, exposed, abs(shift_y), empty);
+    }
+    if (shift_x != 0) {
+      origin_x = (origin_x - shift_x) & MASK;
+      int exposed = (shift_x > 0 ? 0 : TRAILS + shift_x) + origin_x;
+      Empty(exposed, abs(shift_x), 0, TRAILS, empty);
+    }
+  }
+};
+
+#endif /* _TRUE_TRAILS_H_ */
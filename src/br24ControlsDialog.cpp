@@ -333,7 +333,7 @@ void br24RadarRangeControlButton::SetAuto() {
 wxString interference_rejection_names[3] = { _("Off"), _("Normal"), _("High") };;
 wxString target_boost_names[3] = { _("Off"), _("Low"), _("High") };
 wxString timed_idle_times[8] = { _("Off"), _("5 min"), _("10 min"), _("15 min"), _("20 min"), _("25 min"), _("30 min"),  _("35 min") };
-wxString guard_zone_names[3] = { _("Off"), _("Arc"), _("Circle") };
+wxString guard_zone_names[4] = { _("Off"), _("Arc"), _("Circle"), _("Polygon") };
 static wxString sea_auto_names[4] = { _("Off"), _("Harbor"), _("Offshore"), _("Coastal") };
 static wxString mbs_enabled_names[2] = { _("Off"), _("On") };
 
@@ -791,10 +791,12 @@ void br24ControlsDialog::CreateControls() {
   guard_zone_names[0] = _("Off");
   guard_zone_names[1] = _("Arc");
   guard_zone_names[2] = _("Circle");
+  guard_zone_names[3] = _("Polygon");
 #endif
 
   m_guard_zone_type = new wxRadioBox(this, wxID_ANY, wxT(""), wxDefaultPosition, wxDefaultSize, ARRAY_SIZE(guard_zone_names),
                                      guard_zone_names, 1, wxRA_SPECIFY_COLS);
+  m_guard_zone_type->Enable(GZ_POLYGON, false);  // Polygon corners can only be set in the config file
   m_guard_sizer->Add(m_guard_zone_type, 0, wxALIGN_CENTER_HORIZONTAL | wxALL, BORDER);
 
   m_guard_zone_type->Connect(wxEVT_COMMAND_RADIOBOX_SELECTED, wxCommandEventHandler(br24ControlsDialog::OnGuardZoneModeClick), NULL,
@@ -1877,7 +1879,7 @@ void br24ControlsDialog::SetGuardZoneVisibility() {
 
   m_guard_zone->SetType(zoneType);
 
-  if (zoneType == GZ_OFF) {
+  if (zoneType == GZ_OFF || zoneType == GZ_POLYGON) {
     m_start_bearing->Disable();
     m_end_bearing->Disable();
     m_inner_range->Disable();
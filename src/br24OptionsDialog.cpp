@@ -243,6 +243,39 @@ br24OptionsDialog::br24OptionsDialog(wxWindow *parent, PersistentSettings &setti
   m_controlEnable->Connect(wxEVT_COMMAND_CHECKBOX_CLICKED, wxCommandEventHandler(br24OptionsDialog::OnEnableTransmitClick), NULL,
                              this);
 
+  m_Record = new wxCheckBox(this, wxID_ANY, _("Record radar data to capture file"), wxDefaultPosition, wxDefaultSize,
+                            wxALIGN_CENTRE | wxST_NO_AUTORESIZE);
+  itemStaticBoxSizerOptions->Add(m_Record, 0, wxALL, border_size);
+  m_Record->SetValue(m_settings.record_on ? true : false);
+  m_Record->Connect(wxEVT_COMMAND_CHECKBOX_CLICKED, wxCommandEventHandler(br24OptionsDialog::OnRecordClick), NULL, this);
+
+  wxButton *select_record_file =
+      new wxButton(this, wxID_ANY, _("Select capture file"), wxDefaultPosition, small_button_size, 0);
+  select_record_file->Connect(wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(br24OptionsDialog::OnSelectRecordFileClick),
+                              NULL, this);
+  itemStaticBoxSizerOptions->Add(select_record_file, 0, wxALL, border_size);
+
+  m_Replay = new wxCheckBox(this, wxID_ANY, _("Replay capture file instead of network"), wxDefaultPosition, wxDefaultSize,
+                            wxALIGN_CENTRE | wxST_NO_AUTORESIZE);
+  itemStaticBoxSizerOptions->Add(m_Replay, 0, wxALL, border_size);
+  m_Replay->SetValue(m_settings.replay_on ? true : false);
+  m_Replay->Connect(wxEVT_COMMAND_CHECKBOX_CLICKED, wxCommandEventHandler(br24OptionsDialog::OnReplayClick), NULL, this);
+
+  wxButton *select_replay_file =
+      new wxButton(this, wxID_ANY, _("Select replay file"), wxDefaultPosition, small_button_size, 0);
+  select_replay_file->Connect(wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(br24OptionsDialog::OnSelectReplayFileClick),
+                              NULL, this);
+  itemStaticBoxSizerOptions->Add(select_replay_file, 0, wxALL, border_size);
+
+  wxStaticText *replaySpeed =
+      new wxStaticText(this, wxID_ANY, _("Replay speed (0 = max)"), wxDefaultPosition, wxDefaultSize, 0);
+  itemStaticBoxSizerOptions->Add(replaySpeed, 0, wxALL, border_size);
+
+  m_ReplaySpeed = new wxTextCtrl(this, wxID_ANY);
+  itemStaticBoxSizerOptions->Add(m_ReplaySpeed, 0, wxALL, border_size);
+  m_ReplaySpeed->SetValue(wxString::Format(wxT("%d"), m_settings.replay_speed));
+  m_ReplaySpeed->Connect(wxEVT_COMMAND_TEXT_UPDATED, wxCommandEventHandler(br24OptionsDialog::OnReplaySpeedClick), NULL, this);
+
   // Accept/Reject button
   wxStdDialogButtonSizer *DialogButtonSizer = wxDialog::CreateStdDialogButtonSizer(wxOK | wxCANCEL);
   topSizer->Add(DialogButtonSizer, 0, wxALIGN_RIGHT | wxALL, border_size);
@@ -338,4 +371,32 @@ void br24OptionsDialog::OnEnableTransmitClick(wxCommandEvent &event)
   m_settings.enable_transmit = m_controlEnable->GetValue();
 }
 
+void br24OptionsDialog::OnRecordClick(wxCommandEvent &event) { m_settings.record_on = m_Record->GetValue(); }
+
+void br24OptionsDialog::OnSelectRecordFileClick(wxCommandEvent &event) {
+  wxFileDialog *saveDialog = new wxFileDialog(NULL, _("Select Capture File"), wxT(""), m_settings.record_file,
+                                              _("pcapng files (*.pcapng)|*.pcapng|All files (*.*)|*.*"), wxFD_SAVE);
+  int response = saveDialog->ShowModal();
+  if (response == wxID_OK) {
+    m_settings.record_file = saveDialog->GetPath();
+  }
+}
+
+void br24OptionsDialog::OnReplayClick(wxCommandEvent &event) { m_settings.replay_on = m_Replay->GetValue(); }
+
+void br24OptionsDialog::OnSelectReplayFileClick(wxCommandEvent &event) {
+  wxFileDialog *openDialog = new wxFileDialog(NULL, _("Select Replay File"), wxT(""), m_settings.replay_file,
+                                              _("pcapng files (*.pcapng)|*.pcapng|All files (*.*)|*.*"), wxFD_OPEN);
+  int response = openDialog->ShowModal();
+  if (response == wxID_OK) {
+    m_settings.replay_file = openDialog->GetPath();
+  }
+}
+
+void br24OptionsDialog::OnReplaySpeedClick(wxCommandEvent &event) {
+  wxString temp = m_ReplaySpeed->GetValue();
+
+  m_settings.replay_speed = wxMax(strtol(temp.c_str(), 0, 0), 0);
+}
+
 PLUGIN_END_NAMESPACE
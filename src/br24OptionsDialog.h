@@ -67,6 +67,11 @@ class br24OptionsDialog : public wxDialog {
   void OnEmulatorClick(wxCommandEvent& event);
   void OnReverseZoomClick(wxCommandEvent& event);
   void OnEnableTransmitClick(wxCommandEvent &event);
+  void OnRecordClick(wxCommandEvent& event);
+  void OnSelectRecordFileClick(wxCommandEvent& event);
+  void OnReplayClick(wxCommandEvent& event);
+  void OnSelectReplayFileClick(wxCommandEvent& event);
+  void OnReplaySpeedClick(wxCommandEvent& event);
 
   PersistentSettings m_settings;
 
@@ -92,6 +97,9 @@ class br24OptionsDialog : public wxDialog {
   wxCheckBox* m_Emulator;
   wxCheckBox* m_ReverseZoom;
   wxCheckBox* m_controlEnable;
+  wxCheckBox* m_Record;
+  wxCheckBox* m_Replay;
+  wxTextCtrl* m_ReplaySpeed;
 };
 
 PLUGIN_END_NAMESPACE
@@ -119,6 +119,10 @@ br24radar_pi::br24radar_pi(void *ppimgr) : opencpn_plugin_112(ppimgr)
   m_opengl_mode_changed = false;
   m_opencpn_gl_context = 0;
   m_opencpn_gl_context_broken = false;
+  m_reactor = 0;
+  m_recorder = 0;
+  m_replay = 0;
+  m_frame_export = 0;
 
   m_first_init = true;
 }
@@ -268,10 +272,18 @@ int br24radar_pi::Init(void) {
 
   SetRadarWindowViz();
   Notify();
+  m_recorder = new CRMRecorder(this);
+  UpdateRecording();
+  m_reactor = new CRMReactor(this);
+  if (m_reactor->Run() != wxTHREAD_NO_ERROR) {
+    LOG_INFO(wxT("BR24radar_pi: unable to start I/O reactor thread."));
+  }
   m_radar[0]->StartReceive();
   if (m_settings.enable_dual_radar) {
     m_radar[1]->StartReceive();
   }
+  UpdateReplay();
+  UpdateFrameExport();
 
   return PLUGIN_OPTIONS;
 }
@@ -304,6 +316,31 @@ bool br24radar_pi::DeInit(void) {
 
   SaveConfig();
 
+  // Stop all network I/O and frame readers before the radars they serve go away
+  if (m_frame_export) {
+    m_frame_export->Shutdown();
+    m_frame_export->Wait();
+    delete m_frame_export;
+    m_frame_export = 0;
+  }
+  if (m_replay) {
+    m_replay->Shutdown();
+    m_replay->Wait();
+    delete m_replay;
+    m_replay = 0;
+  }
+  if (m_reactor) {
+    LOG_VERBOSE(wxT("BR24radar_pi: I/O reactor request stop"));
+    m_reactor->Shutdown();
+    m_reactor->Wait();
+    delete m_reactor;
+    m_reactor = 0;
+  }
+  if (m_recorder) {
+    delete m_recorder;
+    m_recorder = 0;
+  }
+
   // Delete all 'new'ed objects
   for (int r = 0; r < RADARS; r++) {
     delete m_radar[r];
@@ -363,6 +400,72 @@ void br24radar_pi::ShowPreferencesDialog(wxWindow *parent) {
     if (!m_guard_bogey_confirmed && m_alarm_sound_timeout && m_settings.guard_zone_timeout) {
       m_alarm_sound_timeout = time(0) + m_settings.guard_zone_timeout;
     }
+    UpdateRecording();
+    UpdateReplay();
+    UpdateFrameExport();
+  }
+}
+
+// Start or stop the pcapng capture to follow the record_on/record_file settings.
+void br24radar_pi::UpdateRecording() {
+  if (!m_recorder) {
+    return;
+  }
+  if (m_settings.record_on && m_settings.replay_on &&
+      wxFileName(m_settings.record_file).SameAs(wxFileName(m_settings.replay_file))) {
+    LOG_INFO(wxT("BR24radar_pi: Not recording to %s, it is being replayed"), m_settings.record_file.c_str());
+    m_settings.record_on = false;
+  }
+  if (m_settings.record_on && m_settings.record_file.length() > 0) {
+    if (!m_recorder->Start(m_settings.record_file)) {
+      m_settings.record_on = false;
+    }
+  } else {
+    m_recorder->Stop();
+  }
+}
+
+// Start or restart the capture replay to follow the replay_on/replay_file/replay_speed settings.
+// While replay_on is set the radar controls close their sockets, see CRMControl::Tick().
+void br24radar_pi::UpdateReplay() {
+  if (m_replay && m_settings.replay_on && m_replay->GetFilename() == m_settings.replay_file &&
+      m_replay->GetSpeed() == m_settings.replay_speed) {
+    return;  // Unchanged, keep playing
+  }
+  if (m_replay) {
+    m_replay->Shutdown();
+    m_replay->Wait();
+    delete m_replay;
+    m_replay = 0;
+  }
+  if (m_settings.replay_on && m_settings.replay_file.length() > 0) {
+    m_replay = new CRMReplay(this, m_settings.replay_file, m_settings.replay_speed);
+    if (m_replay->Run() != wxTHREAD_NO_ERROR) {
+      LOG_INFO(wxT("BR24radar_pi: unable to start replay thread."));
+      delete m_replay;
+      m_replay = 0;
+    }
+  }
+}
+
+// Start or stop the frame export to follow the frame_export_dir setting.
+void br24radar_pi::UpdateFrameExport() {
+  if (m_frame_export && m_frame_export->GetDir() == m_settings.frame_export_dir) {
+    return;
+  }
+  if (m_frame_export) {
+    m_frame_export->Shutdown();
+    m_frame_export->Wait();
+    delete m_frame_export;
+    m_frame_export = 0;
+  }
+  if (m_settings.frame_export_dir.length() > 0) {
+    m_frame_export = new CRMFrameExport(this, m_settings.frame_export_dir);
+    if (m_frame_export->Run() != wxTHREAD_NO_ERROR) {
+      LOG_INFO(wxT("BR24radar_pi: unable to start frame export thread."));
+      delete m_frame_export;
+      m_frame_export = 0;
+    }
   }
 }
 
@@ -532,7 +635,7 @@ wxString br24radar_pi::GetGuardZoneText(RadarInfo *ri) {
     }
   }
 
-  for (int z = 0; z < GUARD_ZONES; z++) {
+  for (int z = 0; z < GUARD_ZONES_MAX; z++) {
     int bogeys = ri->m_guard_zone[z]->GetBogeyCount();
     if (bogeys > 0 || (m_guard_bogey_confirmed && bogeys == 0)) {
       if (text.length() > 0) {
@@ -565,7 +668,10 @@ void br24radar_pi::CheckGuardZoneBogeys(void) {
     if (m_radar[r]->m_state.value == RADAR_TRANSMIT) {
       bool bogeys_found_this_radar = false;
 
-      for (size_t z = 0; z < GUARD_ZONES; z++) {
+      for (size_t z = 0; z < GUARD_ZONES_MAX; z++) {
+        if (z >= GUARD_ZONES && m_radar[r]->m_guard_zone[z]->m_type == GZ_OFF) {
+          continue;  // Only list the zones of the config file that are in use
+        }
         int bogeys = m_radar[r]->m_guard_zone[z]->GetBogeyCount();
         if (bogeys > m_settings.guard_zone_threshold) {
           bogeys_found = true;
@@ -785,13 +891,29 @@ void br24radar_pi::Notify(void) {
     for (size_t r = 0; r < RADARS; r++) {
       if (m_radar[r]->m_state.value != RADAR_OFF) {
 	const SMiscRadarInfo & miscInfo = m_radar[r]->m_radarControl->GetMiscInfo();
+        receive_statistics &stats = m_radar[r]->m_statistics;
         t << wxString::Format(wxT("%s\npackets %d/%d\nspokes %d/%d/%d\nmag curr %d SS %d\nrot time %d ms\n"), m_radar[r]->m_name.c_str(),
                               m_radar[r]->m_statistics.packets, m_radar[r]->m_statistics.broken_packets,
                               m_radar[r]->m_statistics.spokes, m_radar[r]->m_statistics.broken_spokes,
                               m_radar[r]->m_statistics.missing_spokes, miscInfo.m_magnetronCurrent, 
 			      miscInfo.m_signalStrength, miscInfo.m_rotationPeriod);
+        t << wxString::Format(wxT("syscalls/spoke %.2f batch %.1f\nring %d dropped %d\n"),
+                              stats.spokes ? (double)stats.receive_syscalls / stats.spokes : 0.0,
+                              stats.receive_batches ? (double)stats.receive_datagrams / stats.receive_batches : 0.0,
+                              stats.ring_high_water, stats.ring_overflows);
+        if (stats.resets) {
+          t << wxString::Format(wxT("resets %d %d us\n"), stats.resets, stats.reset_micros);
+        }
+        if (stats.guard_zone_alarms) {
+          t << wxString::Format(wxT("alarms %d latency %d us max %d us\n"), stats.guard_zone_alarms, stats.guard_zone_alarm_micros,
+                                stats.guard_zone_alarm_max);
+        }
+        t << m_radar[r]->GetSpokeStageStatistics();
       }
     }
+    if (m_replay) {
+      t << wxString::Format(wxT("replay %.0f pkt/s %.0f spokes/s\n"), m_replay->m_packets_per_second, m_replay->m_spokes_per_second);
+    }
     m_pMessageBox->SetStatisticsInfo(t);
     if (t.length() > 0) {
       t.Replace(wxT("\n"), wxT(" "));
@@ -851,6 +973,13 @@ void br24radar_pi::Notify(void) {
     m_radar[r]->m_statistics.missing_spokes = 0;
     m_radar[r]->m_statistics.packets = 0;
     m_radar[r]->m_statistics.spokes = 0;
+    m_radar[r]->m_statistics.receive_syscalls = 0;
+    m_radar[r]->m_statistics.receive_batches = 0;
+    m_radar[r]->m_statistics.receive_datagrams = 0;
+    m_radar[r]->m_statistics.ring_high_water = 0;
+    m_radar[r]->m_statistics.ring_overflows = 0;
+    m_radar[r]->m_statistics.resets = 0;
+    m_radar[r]->m_statistics.reset_micros = 0;
   }
 
   UpdateState();
@@ -1029,7 +1158,11 @@ bool br24radar_pi::LoadConfig(void) {
         pConf->Read(wxString::Format(wxT("Radar%dControlPosY"), r), &y, OFFSCREEN_CONTROL_Y);
         m_settings.control_pos[r] = wxPoint(x, y);
         LOG_DIALOG(wxT("BR24radar_pi: LoadConfig: show_radar[%d]=%d control=%d,%d"), r, v, x, y);
-        for (int i = 0; i < GUARD_ZONES; i++) {
+        for (int i = 0; i < GUARD_ZONES_MAX; i++) {
+          wxString polygon;
+          if (pConf->Read(wxString::Format(wxT("Radar%dZone%dPolygon"), r, i), &polygon)) {
+            m_radar[r]->m_guard_zone[i]->SetPolygon(polygon);
+          }
           pConf->Read(wxString::Format(wxT("Radar%dZone%dStartBearing"), r, i), &m_radar[r]->m_guard_zone[i]->m_start_bearing, 0);
           pConf->Read(wxString::Format(wxT("Radar%dZone%dEndBearing"), r, i), &m_radar[r]->m_guard_zone[i]->m_end_bearing, 0);
           pConf->Read(wxString::Format(wxT("Radar%dZone%dOuterRange"), r, i), &m_radar[r]->m_guard_zone[i]->m_outer_range, 0);
@@ -1046,6 +1179,11 @@ bool br24radar_pi::LoadConfig(void) {
     }
 
     pConf->Read(wxT("AlertAudioFile"), &m_settings.alert_audio_file, m_shareLocn + wxT("alarm.wav"));
+    pConf->Read(wxT("CfarAzimuth"), &m_settings.cfar_azimuth, true);
+    pConf->Read(wxT("CfarDetector"), &m_settings.cfar_on, false);
+    pConf->Read(wxT("CfarGuardCells"), &m_settings.cfar_guard, DEFAULT_CFAR_GUARD);
+    pConf->Read(wxT("CfarScale"), &m_settings.cfar_scale, DEFAULT_CFAR_SCALE);
+    pConf->Read(wxT("CfarTrainingCells"), &m_settings.cfar_training, DEFAULT_CFAR_TRAINING);
     pConf->Read(wxT("ChartOverlay"), &m_settings.chart_overlay, 0);
     pConf->Read(wxT("ColourStrong"), &s, "rgb(255,0,0)");
     m_settings.strong_colour = wxColour(s);
@@ -1057,6 +1195,7 @@ bool br24radar_pi::LoadConfig(void) {
     pConf->Read(wxT("EmulatorOn"), &m_settings.emulator_on, false);
     pConf->Read(wxT("RadarControlActive"), &m_settings.enable_transmit, false);
     pConf->Read(wxT("EnableDualRadar"), &m_settings.enable_dual_radar, false);
+    pConf->Read(wxT("FrameExportDir"), &m_settings.frame_export_dir, wxEmptyString);
     pConf->Read(wxT("GuardZoneDebugInc"), &m_settings.guard_zone_debug_inc, 0);
     pConf->Read(wxT("GuardZoneOnOverlay"), &m_settings.guard_zone_on_overlay, true);
     pConf->Read(wxT("GuardZoneTimeout"), &m_settings.guard_zone_timeout, 30);
@@ -1065,8 +1204,18 @@ bool br24radar_pi::LoadConfig(void) {
     pConf->Read(wxT("IgnoreRadarHeading"), &m_settings.ignore_radar_heading, 0);
     pConf->Read(wxT("MainBangSize"), &m_settings.main_bang_size, 0);
     pConf->Read(wxT("MenuAutoHide"), &m_settings.menu_auto_hide, 0);
+    pConf->Read(wxT("MultiSweepFilterM"), &m_settings.multi_sweep_filter_m, DEFAULT_MULTI_SWEEP_FILTER_M);
+    pConf->Read(wxT("MultiSweepFilterN"), &m_settings.multi_sweep_filter_n, DEFAULT_MULTI_SWEEP_FILTER_N);
     pConf->Read(wxT("PassHeadingToOCPN"), &m_settings.pass_heading_to_opencpn, false);
     pConf->Read(wxT("RadarInterface"), &m_settings.mcast_address);
+    pConf->Read(wxT("ReceiveBatchSize"), &m_settings.receive_batch_size, RECEIVE_BATCH_MAX);
+    pConf->Read(wxT("RecordCapture"), &m_settings.record_on, false);
+    pConf->Read(wxT("RecordCaptureFile"), &m_settings.record_file,
+                *GetpPrivateApplicationDataLocation() + wxFileName::GetPathSeparator() + wxT("rmradar.pcapng"));
+    pConf->Read(wxT("ReplayCapture"), &m_settings.replay_on, false);
+    pConf->Read(wxT("ReplayCaptureFile"), &m_settings.replay_file, m_settings.record_file);
+    pConf->Read(wxT("ReplaySpeed"), &m_settings.replay_speed, 1);
+    m_settings.replay_speed = wxMax(m_settings.replay_speed, 0);
     pConf->Read(wxT("RangeUnits"), &v, 0);
     m_settings.range_units = (RangeUnits)wxMax(wxMin(v, 1), 0);
     m_settings.range_unit_meters = (m_settings.range_units == RANGE_METRIC) ? 1000 : 1852;
@@ -1090,6 +1239,12 @@ bool br24radar_pi::LoadConfig(void) {
 
     m_settings.max_age = wxMax(wxMin(m_settings.max_age, MAX_AGE), MIN_AGE);
     m_settings.refreshrate = wxMax(wxMin(m_settings.refreshrate, 5), 1);
+    m_settings.receive_batch_size = wxMax(wxMin(m_settings.receive_batch_size, RECEIVE_BATCH_MAX), 1);
+    m_settings.multi_sweep_filter_n = wxMax(wxMin(m_settings.multi_sweep_filter_n, HISTORY_SWEEPS), 1);
+    m_settings.multi_sweep_filter_m = wxMax(wxMin(m_settings.multi_sweep_filter_m, m_settings.multi_sweep_filter_n), 1);
+    m_settings.cfar_guard = wxMax(wxMin(m_settings.cfar_guard, CFAR_GUARD_MAX), 0);
+    m_settings.cfar_training = wxMax(wxMin(m_settings.cfar_training, CFAR_TRAINING_MAX), 1);
+    m_settings.cfar_scale = wxMax(m_settings.cfar_scale, 0.0);
 
     SaveConfig();
     return true;
@@ -1107,12 +1262,18 @@ bool br24radar_pi::SaveConfig(void) {
     pConf->Write(wxT("AlarmPosX"), m_settings.alarm_pos.x);
     pConf->Write(wxT("AlarmPosY"), m_settings.alarm_pos.y);
     pConf->Write(wxT("AlertAudioFile"), m_settings.alert_audio_file);
+    pConf->Write(wxT("CfarAzimuth"), m_settings.cfar_azimuth);
+    pConf->Write(wxT("CfarDetector"), m_settings.cfar_on);
+    pConf->Write(wxT("CfarGuardCells"), m_settings.cfar_guard);
+    pConf->Write(wxT("CfarScale"), m_settings.cfar_scale);
+    pConf->Write(wxT("CfarTrainingCells"), m_settings.cfar_training);
     pConf->Write(wxT("ChartOverlay"), m_settings.chart_overlay);
     pConf->Write(wxT("DrawingMethod"), m_settings.drawing_method);
     pConf->Write(wxT("EmulatorOn"), m_settings.emulator_on);
     pConf->Write(wxT("RadarControlActive"), m_settings.enable_transmit);
     pConf->Write(wxT("EnableCOGHeading"), m_settings.enable_cog_heading);
     pConf->Write(wxT("EnableDualRadar"), m_settings.enable_dual_radar);
+    pConf->Write(wxT("FrameExportDir"), m_settings.frame_export_dir);
     pConf->Write(wxT("GuardZoneDebugInc"), m_settings.guard_zone_debug_inc);
     pConf->Write(wxT("GuardZoneOnOverlay"), m_settings.guard_zone_on_overlay);
     pConf->Write(wxT("GuardZoneTimeout"), m_settings.guard_zone_timeout);
@@ -1121,8 +1282,16 @@ bool br24radar_pi::SaveConfig(void) {
     pConf->Write(wxT("IgnoreRadarHeading"), m_settings.ignore_radar_heading);
     pConf->Write(wxT("MainBangSize"), m_settings.main_bang_size);
     pConf->Write(wxT("MenuAutoHide"), m_settings.menu_auto_hide);
+    pConf->Write(wxT("MultiSweepFilterM"), m_settings.multi_sweep_filter_m);
+    pConf->Write(wxT("MultiSweepFilterN"), m_settings.multi_sweep_filter_n);
     pConf->Write(wxT("PassHeadingToOCPN"), m_settings.pass_heading_to_opencpn);
     pConf->Write(wxT("RadarInterface"), m_settings.mcast_address);
+    pConf->Write(wxT("ReceiveBatchSize"), m_settings.receive_batch_size);
+    pConf->Write(wxT("RecordCapture"), m_settings.record_on);
+    pConf->Write(wxT("RecordCaptureFile"), m_settings.record_file);
+    pConf->Write(wxT("ReplayCapture"), m_settings.replay_on);
+    pConf->Write(wxT("ReplayCaptureFile"), m_settings.replay_file);
+    pConf->Write(wxT("ReplaySpeed"), m_settings.replay_speed);
     pConf->Write(wxT("RangeUnits"), (int)m_settings.range_units);
     pConf->Write(wxT("Refreshrate"), m_settings.refreshrate);
     pConf->Write(wxT("ReverseZoom"), m_settings.reverse_zoom);
@@ -1153,7 +1322,14 @@ bool br24radar_pi::SaveConfig(void) {
       pConf->Write(wxString::Format(wxT("Radar%dControlPosY"), r), m_settings.control_pos[r].y);
 
       // LOG_DIALOG(wxT("BR24radar_pi: SaveConfig: show_radar[%d]=%d"), r, m_settings.show_radar[r]);
-      for (int i = 0; i < GUARD_ZONES; i++) {
+      for (int i = 0; i < GUARD_ZONES_MAX; i++) {
+        if (i >= GUARD_ZONES && m_radar[r]->m_guard_zone[i]->m_type == GZ_OFF) {
+          pConf->DeleteEntry(wxString::Format(wxT("Radar%dZone%dType"), r, i));
+          continue;
+        }
+        if (m_radar[r]->m_guard_zone[i]->m_polygon_corners > 0) {
+          pConf->Write(wxString::Format(wxT("Radar%dZone%dPolygon"), r, i), m_radar[r]->m_guard_zone[i]->GetPolygon());
+        }
         pConf->Write(wxString::Format(wxT("Radar%dZone%dStartBearing"), r, i), m_radar[r]->m_guard_zone[i]->m_start_bearing);
         pConf->Write(wxString::Format(wxT("Radar%dZone%dEndBearing"), r, i), m_radar[r]->m_guard_zone[i]->m_end_bearing);
         pConf->Write(wxString::Format(wxT("Radar%dZone%dOuterRange"), r, i), m_radar[r]->m_guard_zone[i]->m_outer_range);
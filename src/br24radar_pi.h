@@ -53,6 +53,10 @@ class br24OptionsDialog;
 // class br24Transmit;
 class br24radar_pi;
 class GuardZoneBogey;
+class CRMReactor;
+class CRMRecorder;
+class CRMReplay;
+class CRMFrameExport;
 
 #define SPOKES (4096)               // BR radars can generate up to 4096 spokes per rotation,
 #define LINES_PER_ROTATION (2048)   // but use only half that in practice
@@ -60,8 +64,9 @@ class GuardZoneBogey;
 #define DEGREES_PER_ROTATION (360)  // Classical math
 #define RADARS (2)                  // Number of radars supported by this PI. 2 since 4G supports 2. More work
                                     // needed if you intend to add multiple radomes to network!
-#define GUARD_ZONES (2)             // Could be increased if wanted
-#define BEARING_LINES (2)           // And these as well
+#define GUARD_ZONES (2)             // Guard zones that can be edited in the control dialog
+#define GUARD_ZONES_MAX (16)        // Guard zones per radar, the others are set in the config file
+#define BEARING_LINES (2)           // Could be increased if wanted
 
 static const int SECONDS_PER_TIMED_IDLE_SETTING = 5 * 60;  // 5 minutes increment for each setting
 static const int SECONDS_PER_TRANSMIT_BURST = 30;
@@ -74,6 +79,23 @@ static const int SECONDS_PER_TRANSMIT_BURST = 30;
 typedef int SpokeBearing;  // A value from 0 -- LINES_PER_ROTATION indicating a bearing (? = North,
                            // +ve = clockwise)
 
+// Samples [start, end> of a spoke that all have the same colour, other than BLOB_NONE
+struct SpokeSpan {
+  UINT16 start;
+  UINT16 end;
+  UINT8 colour;  // BlobColour
+};
+
+// One spoke of a received packet, see RadarInfo::ProcessRadarSpokes()
+struct RadarSpoke {
+  SpokeBearing angle;    // Relative to boat
+  SpokeBearing bearing;  // Relative to North
+  UINT8 *data;
+  size_t len;
+  const SpokeSpan *spans;  // The data as spans, in order; 0 until they have been encoded
+  size_t span_count;
+};
+
 // Use the above to convert from 'raw' headings sent by the radar (0..4095) into classical degrees
 // (0..359) and back
 #define SCALE_RAW_TO_DEGREES(raw) ((raw) * (double)DEGREES_PER_ROTATION / SPOKES)
@@ -132,6 +154,18 @@ struct receive_statistics {
   int spokes;
   int broken_spokes;
   int missing_spokes;
+  int receive_syscalls;   // select() and recv calls made by the receive thread
+  int receive_batches;    // recv calls on the data socket that returned datagrams
+  int receive_datagrams;  // datagrams returned by those calls
+  int ring_high_water;    // most frames waiting in the packet ring for the processing thread
+  int ring_overflows;     // newest datagrams dropped because the packet ring was full
+  int resets;             // range, orientation or geometry changes that reset the image
+  int reset_micros;       // CPU time spent in those resets
+
+  // Not reset every second
+  int guard_zone_alarms;         // alarms raised from the processing thread
+  int guard_zone_alarm_micros;   // time from the end of the zone sweep to the alarm check of the last one
+  int guard_zone_alarm_max;      // the longest of those
 };
 
 // WARNING
@@ -187,7 +221,7 @@ static string ControlTypeNames[CT_MAX] = {
 	"STC Curve"
 };
 
-typedef enum GuardZoneType { GZ_OFF, GZ_ARC, GZ_CIRCLE } GuardZoneType;
+typedef enum GuardZoneType { GZ_OFF, GZ_ARC, GZ_CIRCLE, GZ_POLYGON } GuardZoneType;
 
 typedef enum RadarType { RT_UNKNOWN, RT_BR24, RT_3G, RT_4G } RadarType;
 
@@ -243,17 +277,6 @@ enum VariationSource { VARIATION_SOURCE_NONE, VARIATION_SOURCE_NMEA, VARIATION_S
 
 static const int RangeUnitsToMeters[2] = {1852, 1000};
 
-static const bool HasBitCount2[8] = {
-    false,  // 000
-    false,  // 001
-    false,  // 010
-    true,   // 011
-    false,  // 100
-    true,   // 101
-    true,   // 110
-    true,   // 111
-};
-
 #define DEFAULT_OVERLAY_TRANSPARENCY (5)
 #define MIN_OVERLAY_TRANSPARENCY (0)
 #define MAX_OVERLAY_TRANSPARENCY (10)
@@ -301,8 +324,22 @@ struct PersistentSettings {
   int threshold_green;              // Radar data has to be this strong to show as INTERMEDIATE
   int threshold_blue;               // Radar data has to be this strong to show as WEAK
   int threshold_multi_sweep;        // Radar data has to be this strong not to be ignored in multisweep
+  int multi_sweep_filter_m;         // Multi sweep filter shows returns seen in at least M ...
+  int multi_sweep_filter_n;         // ... of the last N sweeps, N <= HISTORY_SWEEPS
   int main_bang_size;               // Pixels at center to ignore
+  bool cfar_on;                     // Only keep returns that the CFAR detector finds, see CfarDetector.h
+  int cfar_guard;                   // CFAR guard cells on each side
+  int cfar_training;                // CFAR training cells on each side
+  double cfar_scale;                // Times the CFAR noise average that a target has to be
+  bool cfar_azimuth;                // Also average the noise over the previous spoke
   int type_detection_method;        // 0 = default, 1 = ignore reports
+  int receive_batch_size;           // Max datagrams read per data socket wakeup, 1 = one recv() per packet
+  bool record_on;                   // Record all received radar data to record_file
+  wxString record_file;             // pcapng capture file
+  bool replay_on;                   // Feed replay_file to the radars instead of the network
+  wxString replay_file;             // pcapng capture file to replay
+  int replay_speed;                 // 1 = real time, N = N times faster, 0 = as fast as possible
+  wxString frame_export_dir;        // Write every rotation as an image here, see RMFrameExport.h. Empty is off
   wxPoint control_pos[RADARS];      // Saved position of control menu windows
   wxPoint window_pos[RADARS];       // Saved position of radar windows, when floating and not docked
   wxPoint alarm_pos;                // Saved position of alarm window
@@ -387,6 +424,7 @@ class br24radar_pi : public opencpn_plugin_112 {
   void ShowGuardZoneDialog(int radar, int zone);
   void OnGuardZoneDialogClose(RadarInfo *ri);
   void ConfirmGuardZoneBogeys();
+  void CheckGuardZoneBogeys(void);
 
   bool SetControlValue(int radar, ControlType controlType, int value);
 
@@ -405,6 +443,9 @@ class br24radar_pi : public opencpn_plugin_112 {
   void SetMcastIPAddress(wxString &msg);
 
   void SetRadarHeading(double heading = nan(""), bool isTrue = false);
+  void UpdateRecording();
+  void UpdateReplay();
+  void UpdateFrameExport();
 
   wxFont m_font;      // The dialog font at a normal size
   wxFont m_fat_font;  // The dialog font at a bigger size, bold
@@ -412,6 +453,10 @@ class br24radar_pi : public opencpn_plugin_112 {
 
   PersistentSettings m_settings;
   RadarInfo *m_radar[RADARS];
+  CRMReactor *m_reactor;           // I/O thread serving the sockets of all radars
+  CRMRecorder *m_recorder;         // pcapng capture of everything the radars send
+  CRMReplay *m_replay;             // Playback of a capture, when replay_on
+  CRMFrameExport *m_frame_export;  // Writes each rotation as an image, when frame_export_dir is set
   wxString m_perspective[RADARS];  // Temporary storage of window location when plugin is disabled
 
   br24MessageBox *m_pMessageBox;
@@ -461,7 +506,6 @@ class br24radar_pi : public opencpn_plugin_112 {
   void DoTick(void);
   void Select_Clutter(int req_clutter_index);
   void Select_Rejection(int req_rejection_index);
-  void CheckGuardZoneBogeys(void);
   void RenderRadarBuffer(wxDC *pdc, int width, int height);
   void PassHeadingToOpenCPN();
   void CacheSetToolbarToolBitmaps();
@@ -511,6 +555,10 @@ PLUGIN_END_NAMESPACE
 #include "br24MessageBox.h"
 // #include "br24Transmit.h"
 #include "RMControl.h"
+#include "RMReactor.h"
+#include "RMRecorder.h"
+#include "RMReplay.h"
+#include "RMFrameExport.h"
 #include "GuardZone.h"
 #include "RadarInfo.h"
 
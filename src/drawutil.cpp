@@ -161,32 +161,29 @@ void CheckOpenGLError(const wxString& after) {
   }
 }
 
-PolarToCartesianLookupTable* lookupTable = 0;
+template <class G>
+PolarToCartesianLookupTable<G>* GetPolarToCartesianLookupTable() {
+  static PolarToCartesianLookupTable<G>* lookupTable = 0;
 
-PolarToCartesianLookupTable* GetPolarToCartesianLookupTable() {
   if (!lookupTable) {
-    lookupTable = (PolarToCartesianLookupTable*)malloc(sizeof(PolarToCartesianLookupTable));
+    lookupTable = (PolarToCartesianLookupTable<G>*)malloc(sizeof(PolarToCartesianLookupTable<G>));
 
     if (!lookupTable) {
       wxLogError(wxT("BR24radar_pi: Out Of Memory, fatal!"));
       wxAbort();
     }
 
-    // initialise polar_to_cart_y[arc + 1][radius] arrays
-    for (int arc = 0; arc < LINES_PER_ROTATION + 1; arc++) {
-      GLfloat sine = sinf((GLfloat)arc * PI * 2 / LINES_PER_ROTATION);
-      GLfloat cosine = cosf((GLfloat)arc * PI * 2 / LINES_PER_ROTATION);
-      for (int radius = 0; radius < RETURNS_PER_LINE + 1; radius++) {
-        lookupTable->x[arc][radius] = (GLfloat)radius * cosine;
-        lookupTable->y[arc][radius] = (GLfloat)radius * sine;
-        lookupTable->intx[arc][radius] = (int)lookupTable->x[arc][radius];
-        lookupTable->inty[arc][radius] = (int)lookupTable->y[arc][radius];
-      }
+    for (int arc = 0; arc < G::LINES + 1; arc++) {
+      lookupTable->sine[arc] = sinf((GLfloat)arc * PI * 2 / G::LINES);
+      lookupTable->cosine[arc] = cosf((GLfloat)arc * PI * 2 / G::LINES);
     }
   }
   return lookupTable;
 }
 
+template PolarToCartesianLookupTable<GeometryStandard>* GetPolarToCartesianLookupTable<GeometryStandard>();
+template PolarToCartesianLookupTable<GeometryHD>* GetPolarToCartesianLookupTable<GeometryHD>();
+
 typedef struct {
   float x;
   float y;
@@ -33,6 +33,7 @@
 #define _DRAWUTIL_H_
 
 #include "pi_common.h"
+#include "RadarGeometry.h"
 
 PLUGIN_BEGIN_NAMESPACE
 
@@ -41,14 +42,23 @@ extern void DrawOutlineArc(double r1, double r2, double a1, double a2, bool stip
 extern void DrawFilledArc(double r1, double r2, double a1, double a2);
 extern void CheckOpenGLError(const wxString& after);
 
+// One table per geometry, allocated the first time a radar with that geometry is drawn.
+// Only the sine and cosine of each line are kept, so the table is 16 kB for either
+// geometry and stays in cache. The coordinates are computed the same way
+// as when all of them were stored: radius times cosine in float, truncated for int.
+template <class G>
 struct PolarToCartesianLookupTable {
-  GLfloat x[LINES_PER_ROTATION + 1][RETURNS_PER_LINE + 1];
-  GLfloat y[LINES_PER_ROTATION + 1][RETURNS_PER_LINE + 1];
-  int intx[LINES_PER_ROTATION + 1][RETURNS_PER_LINE + 1];
-  int inty[LINES_PER_ROTATION + 1][RETURNS_PER_LINE + 1];
+  GLfloat cosine[G::LINES + 1];
+  GLfloat sine[G::LINES + 1];
+
+  GLfloat x(int arc, int radius) const { return (GLfloat)radius * cosine[arc]; }
+  GLfloat y(int arc, int radius) const { return (GLfloat)radius * sine[arc]; }
+  short intx(int arc, int radius) const { return (short)x(arc, radius); }
+  short inty(int arc, int radius) const { return (short)y(arc, radius); }
 };
 
-extern PolarToCartesianLookupTable* GetPolarToCartesianLookupTable();
+template <class G>
+PolarToCartesianLookupTable<G>* GetPolarToCartesianLookupTable();
 
 extern void DrawRoundRect(float x, float y, float width, float height, float radius = 0.0);
 
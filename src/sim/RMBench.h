@@ -0,0 +1,111 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+/*
+ * Shared by the stand-alone kernel checks and benchmarks in src/sim. Each is a
+ * separate program that compares a plugin kernel with a plain reference, prints
+ * how fast it is and exits non-zero when a result is wrong. Being too slow only
+ * fails when RMBENCH_STRICT is set in the environment, timings on a loaded machine
+ * or under valgrind mean nothing. They use no wxWidgets, so only wx free kernels
+ * can be tested this way.
+ */
+
+#ifndef _RM_BENCH_H_
+#define _RM_BENCH_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_HD_SPOKE_MICROS (610.0)  // 2048 HD spokes per rotation at 48 RPM, the fastest there is
+#define BENCH_BUDGET (0.1)             // Share of a spoke time that one stage may take
+
+static int bench_failures = 0;
+static uint32_t bench_random_state = 2463534242u;
+
+#define BENCH_CHECK(cond, ...)                 \
+	do                                         \
+	{                                          \
+		if (!(cond) && bench_failures++ < 10)  \
+		{                                      \
+			printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+			printf(__VA_ARGS__);               \
+			printf("\n");                      \
+		}                                      \
+	} while (0)
+
+static inline double BenchNow(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// xorshift32, the same sequence on every system
+static inline uint32_t BenchRandom(void)
+{
+	bench_random_state ^= bench_random_state << 13;
+	bench_random_state ^= bench_random_state >> 17;
+	bench_random_state ^= bench_random_state << 5;
+	return bench_random_state;
+}
+
+// Fails when micros is over the share of an HD spoke time that a stage may take, but
+// only when RMBENCH_STRICT is set
+static inline void BenchBudget(const char *what, double micros)
+{
+	if (getenv("RMBENCH_STRICT") && micros >= BENCH_BUDGET * BENCH_HD_SPOKE_MICROS)
+	{
+		bench_failures++;
+		printf("FAIL %s: %.2f us is too slow for HD\n", what, micros);
+	}
+}
+
+// Fails when the new way is not faster than the old one, only when RMBENCH_STRICT is set
+static inline void BenchFaster(const char *what, double micros, double old_micros)
+{
+	if (getenv("RMBENCH_STRICT") && micros >= old_micros)
+	{
+		bench_failures++;
+		printf("FAIL %s: %.2f us is not faster than %.2f us\n", what, micros, old_micros);
+	}
+}
+
+static inline int BenchResult(const char *name)
+{
+	printf("%s: %s\n", name, bench_failures ? "FAILED" : "passed");
+	return bench_failures ? 1 : 0;
+}
+
+#endif /* _RM_BENCH_H_ */
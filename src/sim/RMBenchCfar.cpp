@@ -0,0 +1,166 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+/*
+ * CfarDetect() against a cell by cell CA-CFAR, and its speed on HD spokes: the
+ * prefix sums, the detection and applying it should fit in a share of the time
+ * between two HD spokes, see BenchBudget().
+ */
+
+#include "CfarDetector.h"
+#include "RMBench.h"
+
+#define HD_LINES (2048)
+#define HD_RETURNS (1024)
+#define ROTATIONS (10)
+
+static uint8_t spokes[HD_LINES][HD_RETURNS];
+static uint32_t sums[2][HD_RETURNS + 1];
+static HistoryWord detect[HISTORY_WORDS(HD_RETURNS)];
+
+// Sea clutter near the boat, noise and the odd strong target
+static void MakeSpokes(void)
+{
+	for (int l = 0; l < HD_LINES; l++)
+	{
+		for (int r = 0; r < HD_RETURNS; r++)
+		{
+			int v = BenchRandom() % 60 + (r < 200 ? BenchRandom() % 80 : 0);
+			if (BenchRandom() % 97 == 0)
+			{
+				v = 200 + BenchRandom() % 56;
+			}
+			spokes[l][r] = (uint8_t)v;
+		}
+	}
+}
+
+// The training cells that exist on both sides, of this spoke and of previous when given
+static bool Reference(const uint8_t *data, const uint8_t *previous, size_t len, size_t r, const CfarWindow &window)
+{
+	uint32_t noise = 0;
+	unsigned cells = 0;
+
+	for (size_t k = 0; k < len; k++)
+	{
+		bool lead = k < r && r - k > window.guard && r - k <= window.guard + window.train;
+		bool lag = k > r && k - r > window.guard && k - r <= window.guard + window.train;
+		if (lead || lag)
+		{
+			noise += data[k] + (previous ? previous[k] : 0);
+			cells += previous ? 2 : 1;
+		}
+	}
+	return cells > 0 && (float)data[r] > window.scale / (float)cells * (float)noise;
+}
+
+static void CheckDetect(const CfarWindow &window)
+{
+	static const size_t lengths[] = { 1, 5, 37, 64, 511, 512, 1000, HD_RETURNS };
+
+	for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+	{
+		size_t len = lengths[i];
+		for (int l = 1; l < 20; l++)
+		{
+			for (int neighbour = 0; neighbour < 2; neighbour++)
+			{
+				const uint8_t *previous = neighbour ? spokes[l - 1] : 0;
+
+				CfarPrefixSums(spokes[l], len, sums[0]);
+				CfarPrefixSums(spokes[l - 1], len, sums[1]);
+				memset(detect, 0xff, sizeof(detect));
+				CfarDetect(spokes[l], len, sums[0], neighbour ? sums[1] : 0, window, detect);
+
+				uint32_t sum = 0;
+				for (size_t r = 0; r < len; r++)
+				{
+					sum += spokes[l][r];
+					BENCH_CHECK(sums[0][r + 1] == sum, "prefix sum %u at %u, len %u", (unsigned)sums[0][r + 1], (unsigned)r,
+						(unsigned)len);
+					bool bit = (detect[r / HISTORY_WORD_BITS] >> (r % HISTORY_WORD_BITS)) & 1;
+					BENCH_CHECK(bit == Reference(spokes[l], previous, len, r, window),
+						"detection at %u, len %u, guard %u, train %u, previous %d", (unsigned)r, (unsigned)len, window.guard,
+						window.train, neighbour);
+				}
+				for (size_t r = len; r < HISTORY_WORDS(len) * HISTORY_WORD_BITS; r++)
+				{
+					BENCH_CHECK(!((detect[r / HISTORY_WORD_BITS] >> (r % HISTORY_WORD_BITS)) & 1), "bit %u set beyond len %u",
+						(unsigned)r, (unsigned)len);
+				}
+			}
+		}
+	}
+}
+
+// StageCfar() for every spoke of ROTATIONS HD rotations, in microseconds per spoke
+static double Bench(const CfarWindow &window, bool neighbour)
+{
+	double start = BenchNow();
+
+	for (int rotation = 0; rotation < ROTATIONS; rotation++)
+	{
+		for (int l = 0; l < HD_LINES; l++)
+		{
+			uint32_t *current = sums[l & 1];
+			uint32_t *previous = sums[(l & 1) ^ 1];
+
+			CfarPrefixSums(spokes[l], HD_RETURNS, current);
+			CfarDetect(spokes[l], HD_RETURNS, current, neighbour ? previous : 0, window, detect);
+			HistoryApply(spokes[l], HD_RETURNS, detect);
+		}
+	}
+	return (BenchNow() - start) * 1e6 / (ROTATIONS * HD_LINES);
+}
+
+int main(void)
+{
+	CfarWindow windows[] = {
+		{ DEFAULT_CFAR_GUARD, DEFAULT_CFAR_TRAINING, (float)DEFAULT_CFAR_SCALE },
+		{ 0, 1, 1.5f },
+		{ CFAR_GUARD_MAX, CFAR_TRAINING_MAX, 2.0f },
+	};
+
+	MakeSpokes();
+	for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++)
+	{
+		CheckDetect(windows[w]);
+	}
+
+	for (int neighbour = 0; neighbour < 2; neighbour++)
+	{
+		double micros = Bench(windows[0], neighbour != 0);
+		printf("CFAR %s: %.2f us per HD spoke, %.1f%% of the time between spokes\n",
+			neighbour ? "range and azimuth" : "range", micros, 100.0 * micros / BENCH_HD_SPOKE_MICROS);
+		BenchBudget("CFAR", micros);
+	}
+	return BenchResult("CFAR");
+}
@@ -0,0 +1,166 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+/*
+ * GuardZonePolygonCrossings() against a point in polygon test: along lines in every
+ * direction the parts between the crossings must be inside the polygon exactly when
+ * the point in polygon test says so. The polygons include ones around the boat,
+ * corners on the lines and polygons that cross themselves.
+ */
+
+#include <math.h>
+
+#include "GuardZonePolygon.h"
+#include "RMBench.h"
+
+#define CORNERS_MAX (32)
+#define LINES (2048)
+#define RANDOM_POLYGONS (2000)
+
+// Even-odd rule, the way W. Randolph Franklin's pnpoly does it
+static bool Inside(const double *x, const double *y, size_t n, double px, double py)
+{
+	bool inside = false;
+
+	for (size_t c = 0, d = n - 1; c < n; d = c++)
+	{
+		if ((y[c] > py) != (y[d] > py) && px < (x[d] - x[c]) * (py - y[c]) / (y[d] - y[c]) + x[c])
+		{
+			inside = !inside;
+		}
+	}
+	return inside;
+}
+
+// Within a small distance of an edge, where inside or outside is a matter of rounding
+static bool OnEdge(const double *x, const double *y, size_t n, double px, double py)
+{
+	for (size_t c = 0, d = n - 1; c < n; d = c++)
+	{
+		double ex = x[c] - x[d];
+		double ey = y[c] - y[d];
+		double length = ex * ex + ey * ey;
+		double u = length > 0 ? ((px - x[d]) * ex + (py - y[d]) * ey) / length : 0;
+		u = u < 0 ? 0 : u > 1 ? 1 : u;
+		double qx = x[d] + u * ex - px;
+		double qy = y[d] + u * ey - py;
+		if (qx * qx + qy * qy < 1e-12)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void CheckLine(const double *x, const double *y, size_t n, double dx, double dy, const char *name)
+{
+	double crossing[CORNERS_MAX + 1];
+	size_t crossings = GuardZonePolygonCrossings(x, y, n, dx, dy, crossing);
+
+	BENCH_CHECK(crossings % 2 == 0, "%s: %u crossings", name, (unsigned)crossings);
+	for (size_t i = 1; i < crossings; i++)
+	{
+		BENCH_CHECK(crossing[i - 1] <= crossing[i], "%s: crossings out of order", name);
+	}
+	// Halfway between each two crossings, and beyond the last
+	double from = 0.0;
+	for (size_t i = 0; i <= crossings; i++)
+	{
+		double to = i < crossings ? crossing[i] : from + 1000.0;
+		double s = (from + to) / 2;
+		if (to - from > 1e-6 && !OnEdge(x, y, n, s * dx, s * dy))
+		{
+			bool inside = i % 2 == 1;
+			BENCH_CHECK(inside == Inside(x, y, n, s * dx, s * dy), "%s: at %g along (%g, %g) %s", name, s, dx, dy,
+				inside ? "inside" : "outside");
+		}
+		from = to;
+	}
+}
+
+// The boat must not be on an edge, there it is neither inside nor outside
+static void CheckPolygon(const double *x, const double *y, size_t n, const char *name)
+{
+	static const double axes[][2] = { { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 }, { 1, 1 }, { -1, 1 }, { 2, 1 }, { 1, -3 } };
+
+	for (size_t a = 0; a < sizeof(axes) / sizeof(axes[0]); a++)
+	{
+		CheckLine(x, y, n, axes[a][0], axes[a][1], name);
+	}
+	for (int line = 0; line < LINES; line++)
+	{
+		CheckLine(x, y, n, cos(2 * M_PI * line / LINES), sin(2 * M_PI * line / LINES), name);
+	}
+}
+
+int main(void)
+{
+	// The boat inside: every line starts inside and leaves once
+	double square_x[] = { -100, 100, 100, -100 };
+	double square_y[] = { -50, -50, 150, 150 };
+	double crossing[CORNERS_MAX + 1];
+	for (int line = 0; line < LINES; line++)
+	{
+		size_t crossings = GuardZonePolygonCrossings(square_x, square_y, 4, cos(2 * M_PI * line / LINES),
+			sin(2 * M_PI * line / LINES), crossing);
+		BENCH_CHECK(crossings == 2 && crossing[0] == 0.0 && crossing[1] >= 50.0, "line %d around the boat: %u crossings",
+			line, (unsigned)crossings);
+	}
+	CheckPolygon(square_x, square_y, 4, "around the boat");
+
+	// The boat outside, lines through two corners
+	double away_x[] = { 100, 200, 200, 100 };
+	double away_y[] = { 100, 100, 200, 200 };
+	CheckPolygon(away_x, away_y, 4, "away from the boat");
+
+	// A corner of the boat inside a concave polygon, a line along the (1, 0) and (0, 1) edges
+	double notch_x[] = { -50, 0, 0, 50, 50, -50 };
+	double notch_y[] = { -50, -50, 0, 0, 50, 50 };
+	CheckPolygon(notch_x, notch_y, 6, "notched");
+
+	// Random polygons, many crossing themselves, on a coarse grid so lines hit corners
+	for (int p = 0; p < RANDOM_POLYGONS; p++)
+	{
+		double x[CORNERS_MAX];
+		double y[CORNERS_MAX];
+		size_t n = 3 + BenchRandom() % (CORNERS_MAX - 2);
+		for (size_t c = 0; c < n; c++)
+		{
+			x[c] = (double)((int)(BenchRandom() % 21) - 10) * 10;
+			y[c] = (double)((int)(BenchRandom() % 21) - 10) * 10;
+		}
+		if (!OnEdge(x, y, n, 0, 0))
+		{
+			CheckPolygon(x, y, n, "random");
+		}
+	}
+	return BenchResult("Guard zone polygon");
+}
@@ -0,0 +1,131 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+/*
+ * The Z order of TrueTrailGrid against the row major image it replaced. Index() must
+ * give every cell its own place in the grid, and a rotation of HD spokes, read and
+ * written the way RadarInfo::StageTrails() does, is timed in both layouts. The time
+ * only fails the bench when RMBENCH_STRICT is set.
+ */
+
+#include <math.h>
+
+#include "TrueTrails.h"
+#include "RMBench.h"
+
+#define LINES (2048)
+#define RETURNS (1024)
+#define TRAILS (2 * RETURNS)
+#define ROTATIONS (5)
+
+static TrueTrailGrid<TRAILS> grid;
+static TrailRotation image[TRAILS * TRAILS];
+static uint32_t seen[TRAILS * TRAILS / 32];
+static float cosine[LINES];
+static float sine[LINES];
+
+static void CheckIndex(void)
+{
+	for (int x = 0; x < TRAILS; x++)
+	{
+		for (int y = 0; y < TRAILS; y++)
+		{
+			size_t i = grid.Index(x, y);
+			if (i >= (size_t)TRAILS * TRAILS)
+			{
+				BENCH_CHECK(false, "index %u of %d, %d is outside the grid", (unsigned)i, x, y);
+				continue;
+			}
+			BENCH_CHECK(!(seen[i / 32] & (1u << (i % 32))), "index %u of %d, %d is used twice", (unsigned)i, x, y);
+			seen[i / 32] |= 1u << (i % 32);
+		}
+	}
+	// The torus wraps: x and y are taken modulo TRAILS
+	BENCH_CHECK(grid.Index(-1, TRAILS + 3) == grid.Index(TRAILS - 1, 3), "no wrap around");
+}
+
+/*
+ * Every return of every spoke reads its cell and every tenth return writes it, with
+ * the origin somewhere in the middle. Returns the microseconds per spoke.
+ */
+static double Rotations(bool z_order, unsigned *checksum)
+{
+	int origin_x = grid.origin_x + RETURNS;
+	int origin_y = grid.origin_y + RETURNS;
+	unsigned sum = 0;
+	double start = BenchNow();
+
+	for (int rotation = 0; rotation < ROTATIONS; rotation++)
+	{
+		TrailRotation now = (TrailRotation)(rotation + 1);
+		for (int line = 0; line < LINES; line++)
+		{
+			for (int radius = 0; radius < RETURNS; radius++)
+			{
+				int x = (short)(radius * cosine[line]) + origin_x;
+				int y = (short)(radius * sine[line]) + origin_y;
+				size_t i = z_order ? grid.Index(x, y) : (size_t)(x & grid.MASK) * TRAILS + (y & grid.MASK);
+				TrailRotation *cells = z_order ? grid.cells : image;
+
+				sum += cells[i];
+				if (radius % 10 == line % 10)
+				{
+					cells[i] = now;
+				}
+			}
+		}
+	}
+	*checksum = sum;
+	return (BenchNow() - start) * 1e6 / (ROTATIONS * LINES);
+}
+
+int main(void)
+{
+	for (int line = 0; line < LINES; line++)
+	{
+		cosine[line] = (float)cos(2 * M_PI * line / LINES);
+		sine[line] = (float)sin(2 * M_PI * line / LINES);
+	}
+	CheckIndex();
+
+	// Somewhere the ship has moved to, the row major image uses the same origin
+	grid.Shift(137, -59, 0);
+	unsigned row_sum;
+	unsigned z_sum;
+	double row_micros = Rotations(false, &row_sum);
+	double z_micros = Rotations(true, &z_sum);
+
+	printf("Trails of HD spokes: row major %.2f us, Z order %.2f us per spoke, %.2f times faster\n", row_micros, z_micros,
+		row_micros / z_micros);
+	BENCH_CHECK(row_sum == z_sum, "the layouts read different stamps, %u and %u", row_sum, z_sum);
+	BenchBudget("Trail order", z_micros);
+	return BenchResult("Trail order");
+}
@@ -0,0 +1,158 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+/*
+ * TrueTrailGrid::Shift() against the memmove of the whole image that it replaced:
+ * after random moves of the ship, with trail cells set in between, every cell must
+ * read the same relative to the ship. Then the time each takes per move, which only
+ * fails the bench when RMBENCH_STRICT is set.
+ */
+
+#include "TrueTrails.h"
+#include "RMBench.h"
+
+#define TRAILS (2048)  // HD, 2 * 1024 returns
+#define MOVES (300)
+#define BENCH_MOVES (1000)
+
+static TrueTrailGrid<TRAILS> grid;
+static TrailRotation image[TRAILS][TRAILS];  // As it was, row x, column y
+
+// The old RadarInfo::UpdateTrailPosition() code, with empty instead of 0
+static void MemmoveShift(int shift_x, int shift_y, TrailRotation empty)
+{
+	if (shift_y > 0)
+	{
+		for (int x = 0; x < TRAILS; x++)
+		{
+			memmove(&image[x][shift_y], &image[x][0], (TRAILS - shift_y) * sizeof(TrailRotation));
+			for (int y = 0; y < shift_y; y++)
+			{
+				image[x][y] = empty;
+			}
+		}
+	}
+	if (shift_y < 0)
+	{
+		for (int x = 0; x < TRAILS; x++)
+		{
+			memmove(&image[x][0], &image[x][-shift_y], (TRAILS + shift_y) * sizeof(TrailRotation));
+			for (int y = TRAILS + shift_y; y < TRAILS; y++)
+			{
+				image[x][y] = empty;
+			}
+		}
+	}
+	if (shift_x > 0)
+	{
+		memmove(&image[shift_x][0], &image[0][0], (size_t)TRAILS * (TRAILS - shift_x) * sizeof(TrailRotation));
+		for (int x = 0; x < shift_x; x++)
+		{
+			for (int y = 0; y < TRAILS; y++)
+			{
+				image[x][y] = empty;
+			}
+		}
+	}
+	if (shift_x < 0)
+	{
+		memmove(&image[0][0], &image[-shift_x][0], (size_t)TRAILS * (TRAILS + shift_x) * sizeof(TrailRotation));
+		for (int x = TRAILS + shift_x; x < TRAILS; x++)
+		{
+			for (int y = 0; y < TRAILS; y++)
+			{
+				image[x][y] = empty;
+			}
+		}
+	}
+}
+
+static int RandomShift(int most)
+{
+	return (int)(BenchRandom() % (2 * most + 1)) - most;
+}
+
+static void CheckShift(void)
+{
+	TrailRotation empty = 0;
+
+	for (int move = 0; move < MOVES; move++)
+	{
+		for (int k = 0; k < 500; k++)
+		{
+			int x = BenchRandom() % TRAILS;
+			int y = BenchRandom() % TRAILS;
+			TrailRotation stamp = (TrailRotation)(move + 1);
+
+			image[x][y] = stamp;
+			grid.cells[grid.Index(x + grid.origin_x, y + grid.origin_y)] = stamp;
+		}
+		// Mostly a few cells, now and then most of the image
+		int most = move % 50 == 0 ? TRAILS - 1 : 10;
+		int shift_x = RandomShift(most);
+		int shift_y = RandomShift(most);
+		empty = (TrailRotation)(move / 7);
+		MemmoveShift(shift_x, shift_y, empty);
+		grid.Shift(shift_x, shift_y, empty);
+	}
+
+	for (int x = 0; x < TRAILS; x++)
+	{
+		for (int y = 0; y < TRAILS; y++)
+		{
+			TrailRotation cell = grid.cells[grid.Index(x + grid.origin_x, y + grid.origin_y)];
+			BENCH_CHECK(cell == image[x][y], "cell %d, %d is %u instead of %u", x, y, cell, image[x][y]);
+		}
+	}
+}
+
+int main(void)
+{
+	CheckShift();
+
+	// The ship moving one cell at a time, diagonally
+	double start = BenchNow();
+	for (int i = 0; i < BENCH_MOVES; i++)
+	{
+		MemmoveShift(i & 1 ? 1 : -1, i & 2 ? 1 : -1, 0);
+	}
+	double memmove_micros = (BenchNow() - start) * 1e6 / BENCH_MOVES;
+	start = BenchNow();
+	for (int i = 0; i < BENCH_MOVES; i++)
+	{
+		grid.Shift(i & 1 ? 1 : -1, i & 2 ? 1 : -1, 0);
+	}
+	double torus_micros = (BenchNow() - start) * 1e6 / BENCH_MOVES;
+
+	printf("Trails %d x %d, one cell move: memmove %.1f us, torus %.1f us\n", TRAILS, TRAILS, memmove_micros, torus_micros);
+	BenchFaster("Trail shift", torus_micros, memmove_micros);
+	return BenchResult("Trail shift");
+}
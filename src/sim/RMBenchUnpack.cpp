@@ -0,0 +1,208 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+/*
+ * Every RMUnpackRLE() kernel that this CPU can run against the loop that
+ * CRMControl::ProcessScanData() used before it, on random scan lines with and without
+ * runs, with cut off escapes at the end, for short and full destinations, and how
+ * much faster each is.
+ */
+
+#include "RMUnpack.h"
+#include "RMBench.h"
+
+#define RLE_ESCAPE (0x5c)
+#define LINE_SAMPLES (512)
+#define MAX_SOURCE (400)
+#define CASES (200000)
+#define BENCH_LINES (4096)
+#define BENCH_ROUNDS (100)
+
+/*
+ * The loop as it was, writing as much as the source says. Only used on sources
+ * that end with a complete escape.
+ */
+static size_t Reference(const uint8_t *sData, size_t len, uint8_t *dData, size_t *consumed)
+{
+	size_t iS = 0;
+	size_t iD = 0;
+
+	while (iS < len)
+	{
+		if (*sData != RLE_ESCAPE)
+		{
+			*dData++ = (((*sData) & 0x0f) << 4) + 0x0f;
+			*dData++ = ((*sData) & 0xf0) + 0x0f;
+			sData++;
+			iS++;
+			iD += 2;
+		}
+		else
+		{
+			uint8_t nFill = sData[1];
+			uint8_t cFill = sData[2];
+
+			for (int i = 0; i < nFill; i++)
+			{
+				*dData++ = ((cFill & 0x0f) << 4) + 0x0f;
+				*dData++ = (cFill & 0xf0) + 0x0f;
+			}
+			sData += 3;
+			iS += 3;
+			iD += nFill * 2;
+		}
+	}
+	*consumed = iS;
+	return iD;
+}
+
+// A line of len bytes with an escape every 1 in 'runs' bytes, none when runs is 0
+static size_t MakeLine(uint8_t *src, size_t len, unsigned runs)
+{
+	size_t i = 0;
+
+	while (i < len)
+	{
+		if (runs && BenchRandom() % runs == 0)
+		{
+			if (i + 3 > len)
+			{
+				break;  // The reference cannot handle a cut off escape
+			}
+			src[i++] = RLE_ESCAPE;
+			src[i++] = (uint8_t)(BenchRandom() % 24);
+			src[i++] = (uint8_t)BenchRandom();
+		}
+		else
+		{
+			uint8_t b = (uint8_t)BenchRandom();
+			src[i++] = b == RLE_ESCAPE ? 0 : b;
+		}
+	}
+	return i;
+}
+
+static void CheckEquivalence(const RMUnpackKernelInfo &kernel)
+{
+	static uint8_t src[MAX_SOURCE + 2];
+	static uint8_t expected[MAX_SOURCE * 2 * 255];
+	static uint8_t out[2 * LINE_SAMPLES + 32];
+
+	for (int t = 0; t < CASES; t++)
+	{
+		size_t complete = MakeLine(src, BenchRandom() % MAX_SOURCE, BenchRandom() % 4 * 8);
+		size_t dst_len = BenchRandom() % 3 == 0 ? (BenchRandom() % (2 * LINE_SAMPLES)) & ~1 : LINE_SAMPLES;
+		size_t expected_consumed;
+		size_t expected_len = Reference(src, complete, expected, &expected_consumed);
+
+		// Now and then the line ends in an escape without its count, or without its byte.
+		// That gives no samples but is used up.
+		size_t len = complete;
+		if (BenchRandom() % 4 == 0)
+		{
+			src[len++] = RLE_ESCAPE;
+			if (BenchRandom() % 2)
+			{
+				src[len++] = (uint8_t)(BenchRandom() % 24);
+			}
+			expected_consumed = len;
+		}
+
+		memset(out, 0xaa, sizeof(out));
+		size_t consumed;
+		size_t n = kernel.unpack(src, len, out, dst_len, &consumed);
+
+		size_t want = expected_len < dst_len ? expected_len : dst_len;
+		BENCH_CHECK(n == want, "%s case %d: %u samples instead of %u", kernel.name, t, (unsigned)n, (unsigned)want);
+		BENCH_CHECK(memcmp(out, expected, n < want ? n : want) == 0, "%s case %d: other samples", kernel.name, t);
+		BENCH_CHECK(out[dst_len] == 0xaa, "%s case %d: written beyond %u", kernel.name, t, (unsigned)dst_len);
+		if (expected_len < dst_len)  // When dst fills up runs of 0 pairs may be left over
+		{
+			BENCH_CHECK(consumed == expected_consumed, "%s case %d: consumed %u instead of %u", kernel.name, t,
+				(unsigned)consumed, (unsigned)expected_consumed);
+		}
+	}
+}
+
+static uint8_t lines[BENCH_LINES][LINE_SAMPLES / 2];
+static size_t lengths[BENCH_LINES];
+static uint8_t out[LINE_SAMPLES * 255];
+
+// Microseconds per line for kernel, or for the old loop when kernel is null
+static double Bench(RMUnpackKernel kernel)
+{
+	volatile size_t sink = 0;
+	double start = BenchNow();
+
+	for (int round = 0; round < BENCH_ROUNDS; round++)
+	{
+		for (int l = 0; l < BENCH_LINES; l++)
+		{
+			size_t consumed;
+			sink += kernel ? kernel(lines[l], lengths[l], out, sizeof(out), &consumed)
+			               : Reference(lines[l], lengths[l], out, &consumed);
+		}
+	}
+	return (BenchNow() - start) * 1e6 / (BENCH_ROUNDS * BENCH_LINES);
+}
+
+int main(void)
+{
+	size_t count;
+	const RMUnpackKernelInfo *kernels = RMUnpackKernels(&count);
+
+	for (size_t k = 0; k < count; k++)
+	{
+		CheckEquivalence(kernels[k]);
+	}
+
+	// Lines as the radar sends them: about one run per 20 bytes
+	size_t bytes = 0;
+	for (int l = 0; l < BENCH_LINES; l++)
+	{
+		lengths[l] = MakeLine(lines[l], sizeof(lines[l]), 20);
+		bytes += lengths[l];
+	}
+	double old_micros = Bench(0);
+	printf("RLE old loop: %.0f MB/s, %.2f us per line\n", bytes / old_micros / BENCH_LINES, old_micros);
+	for (size_t k = 0; k < count; k++)
+	{
+		double micros = Bench(kernels[k].unpack);
+		printf("RLE %s%s: %.0f MB/s, %.2f us per line, %.1f times the old loop\n", kernels[k].name,
+			k == 0 ? " (used)" : "", bytes / micros / BENCH_LINES, micros, old_micros / micros);
+		if (k == 0)
+		{
+			BenchBudget("RLE", micros);
+			BenchFaster("RLE", micros, old_micros);
+		}
+	}
+	return BenchResult("RLE");
+}
@@ -0,0 +1,867 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Navico BR24 Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+/*
+ * Stand-alone Raymarine radar simulator.
+ *
+ * Announces itself on the SeaTalk-HS group like a real radar, streams scan data
+ * in the regular (RLE) or HD layout to a multicast group, obeys the rd_msg_*
+ * control messages that CRMControl sends and answers them with SRadarFeedback,
+ * SRadarPresetFeedback and SCurveFeedback messages.
+ *
+ * It uses no wxWidgets and no plugin code apart from RMProtocol.h, so it can be
+ * run next to OpenCPN on the same machine: multicast loopback delivers the
+ * packets to the plugin through the chosen (non-loopback) interface.
+ *
+ * The spoke rate, spokes per packet, packet loss and send jitter can be set to
+ * see how the plugin copes with a saturated or lossy network.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "RMProtocol.h"
+
+#define SIM_SPOKES (2048)              // Spokes per rotation
+#define SIM_RETURNS (512)              // Samples per spoke in the regular layout
+#define SIM_HD_RETURNS (1024)          // Samples per spoke in the HD layout
+#define SIM_MAX_DATAGRAM (2048)        // Must fit RECEIVE_BUFFER_SIZE in the plugin
+#define SIM_WARMUP_SECONDS (10)
+#define SIM_DATA_GROUP "232.1.1.1"
+#define SIM_DATA_PORT (2574)
+#define SIM_COMMAND_PORT (2575)
+
+static const uint32_t sim_ranges[11] = { 125, 250, 500, 750, 1500, 3000, 6000, 12000, 24000, 48000, 72000 };
+static const uint8_t sim_wakeup_msg[] = "ABCDEFGHIJKLMNOP";
+
+struct SSimOptions {
+	struct in_addr interface;
+	struct in_addr data_group;
+	int data_port;
+	int command_port;
+	double spoke_rate;      // Spokes per second
+	int spokes_per_packet;
+	double loss;            // Fraction of scan packets that is not sent
+	double jitter;          // Max extra delay per scan packet, seconds
+	bool hd;
+	bool transmit;
+	int duration;           // Seconds, 0 = run until interrupted
+	int verbose;
+};
+
+// What the radar would report back in its feedback messages
+struct SSimState {
+	uint8_t status;         // 0 standby, 1 transmit, 2 warmup, 3 off
+	int warmup_left;
+	uint8_t range_id;
+	uint8_t gain;
+	uint8_t auto_gain;
+	uint8_t sea;
+	uint8_t auto_sea;
+	uint8_t rain_enabled;
+	uint8_t rain;
+	uint8_t ftc_enabled;
+	uint8_t ftc;
+	uint8_t tune;
+	uint8_t auto_tune;
+	uint8_t coarse_tune;
+	int16_t bearing_offset;
+	uint8_t interference_rejection;
+	uint8_t target_expansion;
+	uint8_t mbs_enabled;
+	uint8_t display_timing;
+	uint8_t stc_preset;
+	uint8_t curve;
+};
+
+struct SSimStatistics {
+	long packets;
+	long dropped;
+	long spokes;
+	long bytes;
+	long commands;
+};
+
+static SSimOptions opt;
+static SSimState state;
+static SSimStatistics stats;
+static int tx_socket = -1;
+static int command_socket = -1;
+static int wakeup_socket = -1;
+static volatile bool quit = false;
+static uint32_t random_state = 0x12345678;
+
+static void OnSignal(int sig)
+{
+	quit = true;
+}
+
+static double Now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// xorshift32, reproducible between runs unlike rand() on some systems
+static double Random(void)
+{
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return (random_state & 0xffffff) / (double)0x1000000;
+}
+
+static bool FindInterface(struct in_addr *addr)
+{
+	struct ifaddrs *list, *i;
+	bool found = false;
+
+	if (getifaddrs(&list))
+	{
+		perror("getifaddrs");
+		return false;
+	}
+	// Same rule as VALID_IPV4_ADDRESS in the plugin, which ignores loopback
+	for (i = list; i && !found; i = i->ifa_next)
+	{
+		if (i->ifa_addr && i->ifa_addr->sa_family == AF_INET && (i->ifa_flags & IFF_UP) &&
+			!(i->ifa_flags & IFF_LOOPBACK) && (i->ifa_flags & IFF_MULTICAST))
+		{
+			*addr = ((struct sockaddr_in *)i->ifa_addr)->sin_addr;
+			found = true;
+		}
+	}
+	freeifaddrs(list);
+	return found;
+}
+
+static int OpenSender(void)
+{
+	unsigned char loop = 1;
+	unsigned char ttl = 1;
+	int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+	if (s < 0)
+	{
+		perror("socket");
+		return -1;
+	}
+	if (setsockopt(s, IPPROTO_IP, IP_MULTICAST_IF, &opt.interface, sizeof(opt.interface)) ||
+		setsockopt(s, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) ||
+		setsockopt(s, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)))
+	{
+		perror("setsockopt multicast");
+		close(s);
+		return -1;
+	}
+	return s;
+}
+
+static int OpenReceiver(int port, const char *group)
+{
+	int one = 1;
+	struct sockaddr_in adr;
+	int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+	if (s < 0)
+	{
+		perror("socket");
+		return -1;
+	}
+	setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	memset(&adr, 0, sizeof(adr));
+	adr.sin_family = AF_INET;
+	adr.sin_addr.s_addr = htonl(INADDR_ANY);
+	adr.sin_port = htons(port);
+	if (bind(s, (struct sockaddr *)&adr, sizeof(adr)))
+	{
+		perror("bind");
+		close(s);
+		return -1;
+	}
+	if (group)
+	{
+		struct ip_mreq mreq;
+		mreq.imr_interface = opt.interface;
+		inet_aton(group, &mreq.imr_multiaddr);
+		if (setsockopt(s, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)))
+		{
+			perror("IP_ADD_MEMBERSHIP");
+			close(s);
+			return -1;
+		}
+	}
+	return s;
+}
+
+static void SendTo(const void *data, size_t len, struct in_addr group, int port)
+{
+	struct sockaddr_in adr;
+
+	memset(&adr, 0, sizeof(adr));
+	adr.sin_family = AF_INET;
+	adr.sin_addr = group;
+	adr.sin_port = htons(port);
+	if (sendto(tx_socket, data, len, 0, (struct sockaddr *)&adr, sizeof(adr)) < 0 && opt.verbose)
+	{
+		perror("sendto");
+	}
+}
+
+static void SendData(const void *data, size_t len)
+{
+	SendTo(data, len, opt.data_group, opt.data_port);
+}
+
+static void SendAnnounce(void)
+{
+	SRMRadarFunc func;
+	struct in_addr announce;
+
+	memset(&func, 0, sizeof(func));
+	func.dev_id = 0x53494d00;  // "SIM"
+	func.func_id = 1;
+	func.mcast_ip = ntohl(opt.data_group.s_addr);
+	func.mcast_port = opt.data_port;
+	func.radar_ip = ntohl(opt.interface.s_addr);
+	func.radar_port = opt.command_port;
+
+	inet_aton(SEATALK_HS_ANNOUNCE_GROUP, &announce);
+	SendTo(&func, sizeof(func), announce, SEATALK_HS_ANNOUNCE_PORT);
+}
+
+static void SendFeedback(void)
+{
+	SRadarFeedback fb;
+
+	memset(&fb, 0, sizeof(fb));
+	fb.type = RM_MSG_FEEDBACK;
+	memcpy(fb.range_values, sim_ranges, sizeof(fb.range_values));
+	fb.status = state.status;
+	fb.warmup_time = state.status == 2 ? state.warmup_left : 0;
+	fb.signal_strength = 5;
+	fb.range_id = state.range_id;
+	fb.auto_gain = state.auto_gain;
+	fb.gain = state.gain;
+	fb.auto_sea = state.auto_sea;
+	fb.sea_value = state.sea;
+	fb.rain_enabled = state.rain_enabled;
+	fb.rain_value = state.rain;
+	fb.ftc_enabled = state.ftc_enabled;
+	fb.ftc_value = state.ftc;
+	fb.auto_tune = state.auto_tune;
+	fb.tune = state.tune;
+	fb.bearing_offset = state.bearing_offset;
+	fb.interference_rejection = state.interference_rejection;
+	fb.target_expansion = state.target_expansion;
+	fb.mbs_enabled = state.mbs_enabled;
+	SendData(&fb, sizeof(fb));
+}
+
+static void SendPresetFeedback(void)
+{
+	SRadarPresetFeedback fb;
+
+	memset(&fb, 0, sizeof(fb));
+	fb.type = RM_MSG_PRESET_FEEDBACK;
+	fb.magnetron_hours = 1234;
+	fb.magnetron_current = 20;
+	fb.rotation_time = (uint16_t)(1000. * SIM_SPOKES / opt.spoke_rate);
+	fb.stc_preset_max = 255;
+	fb.coarse_tune_arr[0] = fb.coarse_tune_arr[1] = fb.coarse_tune_arr[2] = state.coarse_tune;
+	fb.fine_tune_arr[0] = fb.fine_tune_arr[1] = fb.fine_tune_arr[2] = state.tune;
+	fb.display_timing_value = state.display_timing;
+	fb.stc_preset_value = state.stc_preset;
+	fb.min_gain = 0;
+	fb.max_gain = 100;
+	fb.min_sea = 0;
+	fb.max_sea = 100;
+	fb.min_rain = 0;
+	fb.max_rain = 100;
+	fb.min_ftc = 0;
+	fb.max_ftc = 100;
+	fb.gain_value = state.gain;
+	fb.sea_value = state.sea;
+	fb.fine_tune_value = state.tune;
+	fb.coarse_tune_value = state.coarse_tune;
+	fb.signal_strength_value = 5;
+	SendData(&fb, sizeof(fb));
+}
+
+static void SendCurveFeedback(void)
+{
+	SCurveFeedback fb;
+
+	fb.type = RM_MSG_CURVE_FEEDBACK;
+	fb.curve_value = state.curve;
+	SendData(&fb, sizeof(fb));
+}
+
+/*
+ * Apply one of the rd_msg_* messages from RMControl.cpp. The first two bytes
+ * select the control, the layouts are documented next to those arrays.
+ */
+static void HandleCommand(const uint8_t *data, int len)
+{
+	if (len < 8)
+	{
+		return;
+	}
+	stats.commands++;
+
+	uint16_t code = data[0] | (data[1] << 8);
+	bool feedback = true;
+
+	switch (code)
+	{
+	case 0x8000:  // 1s keepalive
+	case 0x8903:  // 5s keepalive
+	case 0x8102:  // Sent once after connecting
+		feedback = false;
+		break;
+	case 0x8001:  // Transmit on/off, power off
+		if (data[4] == 3)
+		{
+			state.status = 3;
+		}
+		else if (state.status == 0 || state.status == 1)
+		{
+			state.status = data[4] ? 1 : 0;
+		}
+		break;
+	case 0x8101:
+		if (len >= 9 && data[8] < 11)
+		{
+			state.range_id = data[8];
+		}
+		break;
+	case 0x8201:
+		if (len >= 17) state.mbs_enabled = data[16];
+		break;
+	case 0x8202:
+		if (len >= 9) state.display_timing = data[8];
+		break;
+	case 0x8203:
+		if (len >= 9) state.stc_preset = data[8];
+		break;
+	case 0x8204:
+		state.coarse_tune = data[4];
+		break;
+	case 0x8207:
+		state.bearing_offset = (int16_t)(data[4] | (data[5] << 8));
+		break;
+	case 0x8301:  // Gain, byte 8 selects auto (16) or value (20)
+		if (len >= 21 && data[8] == 0) state.gain = data[20];
+		else if (len >= 17) state.auto_gain = data[16];
+		break;
+	case 0x8302:
+		if (len >= 21 && data[8] == 0) state.sea = data[20];
+		else if (len >= 17) state.auto_sea = data[16];
+		break;
+	case 0x8303:
+		if (len >= 21 && data[8] == 0) state.rain = data[20];
+		else if (len >= 17) state.rain_enabled = data[16];
+		break;
+	case 0x8304:
+		if (len >= 21 && data[8] == 0) state.ftc = data[20];
+		else if (len >= 17) state.ftc_enabled = data[16];
+		break;
+	case 0x8305:  // Tune, byte 4 selects auto (12) or fine tune (16)
+		if (data[4] == 1 && len >= 13) state.auto_tune = data[12];
+		else if (len >= 17) state.tune = data[16];
+		break;
+	case 0x8306:
+		if (len >= 9) state.target_expansion = data[8];
+		break;
+	case 0x8307:
+		state.interference_rejection = data[4];
+		break;
+	case 0x830a:
+		state.curve = data[4];
+		SendCurveFeedback();
+		break;
+	default:
+		if (opt.verbose)
+		{
+			fprintf(stderr, "Unknown command %04x, %d bytes\n", code, len);
+		}
+		feedback = false;
+		break;
+	}
+
+	if (opt.verbose >= 2)
+	{
+		fprintf(stderr, "Command %04x, %d bytes\n", code, len);
+	}
+	if (feedback)
+	{
+		SendFeedback();
+		SendPresetFeedback();
+	}
+}
+
+/*
+ * Synthetic picture: sea clutter around the center, a coastline to the north
+ * and a few targets that move a little every rotation. Returns are 0..255.
+ */
+static void GenerateSpoke(int azimuth, int rotation, uint8_t *returns, int count)
+{
+	double angle = 2. * M_PI * azimuth / SIM_SPOKES;
+	double gain = state.auto_gain ? 0.75 : state.gain / 100.;
+	double sea = state.auto_sea ? 0.5 : 1. - state.sea / 100.;
+	double rain = state.rain_enabled ? state.rain / 100. : 0.;
+	int coast = -1;
+
+	if (cos(angle) > 0.5)
+	{
+		coast = (int)(count * (0.65 + 0.1 * sin(3. * angle)));
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		double r = (double)i / count;
+		double v = 0.;
+
+		v += sea * exp(-r * 12.) * (0.4 + 0.6 * Random());
+		v += 0.05 * (1. - rain) * Random();
+		if (coast >= 0 && i >= coast)
+		{
+			v += 0.8 + 0.2 * Random();
+		}
+		v *= 0.5 + gain;
+		returns[i] = (uint8_t)(v >= 1. ? 255 : v * 255.);
+	}
+
+	// Three targets on different courses
+	for (int t = 0; t < 3; t++)
+	{
+		int target_azimuth = (t * 700 + rotation * (t + 1)) % SIM_SPOKES;
+		int target_range = count / 4 + t * count / 6 + (rotation * (t + 1)) % (count / 8);
+		int d = azimuth - target_azimuth;
+		if (d > SIM_SPOKES / 2) d -= SIM_SPOKES;
+		if (d < -SIM_SPOKES / 2) d += SIM_SPOKES;
+		if (abs(d) <= 3)
+		{
+			for (int i = target_range - count / 128; i <= target_range + count / 128; i++)
+			{
+				returns[i] = 255;
+			}
+		}
+	}
+}
+
+// Pack 512 returns as 4 bit pairs and run length encode them, see ProcessScanData()
+static size_t EncodeRegular(const uint8_t *returns, uint8_t *out)
+{
+	uint8_t packed[SIM_RETURNS / 2];
+	size_t n = 0;
+
+	for (int i = 0; i < SIM_RETURNS / 2; i++)
+	{
+		packed[i] = (returns[2 * i] >> 4) | (returns[2 * i + 1] & 0xf0);
+	}
+
+	for (int i = 0; i < SIM_RETURNS / 2;)
+	{
+		int run = 1;
+		while (i + run < SIM_RETURNS / 2 && run < 255 && packed[i + run] == packed[i])
+		{
+			run++;
+		}
+		if (run >= 3 || packed[i] == 0x5c)
+		{
+			if (packed[i] == 0x5c && run < 3)
+			{
+				run = 1;  // 0x5c can only be sent escaped
+			}
+			out[n++] = 0x5c;
+			out[n++] = run;
+			out[n++] = packed[i];
+			i += run;
+		}
+		else
+		{
+			out[n++] = packed[i++];
+		}
+	}
+	return n;
+}
+
+// Worst case size of one spoke in a scan packet
+static size_t MaxSpokeSize(void)
+{
+	size_t data = opt.hd ? SIM_HD_RETURNS : SIM_RETURNS / 2 * 3;
+	return sizeof(CRMScanHeader) + sizeof(CRMOptHeader) + sizeof(CRMScanData) + data + 3;
+}
+
+/*
+ * Build one scan message with up to spokes_per_packet spokes, fewer when the
+ * next one might not fit SIM_MAX_DATAGRAM. Returns the length, *spokes is set
+ * to the number of spokes in the message.
+ */
+static size_t BuildScanPacket(uint8_t *buf, int azimuth, int rotation, uint32_t spoke_count, int *spokes)
+{
+	CRMPacketHeader *header = (CRMPacketHeader *)buf;
+	CRMScanData *data = 0;
+	size_t len = sizeof(CRMPacketHeader);
+	int s;
+
+	memset(header, 0, sizeof(*header));
+	header->type = RM_MSG_SCAN_DATA;
+	header->something_1 = 0x1c;
+	header->spoke_count = opt.hd ? spoke_count : 0;
+	header->something_3 = 1;
+	header->something_4 = opt.hd ? 0x400 : 0;
+
+	for (s = 0; s < opt.spokes_per_packet && len + MaxSpokeSize() <= SIM_MAX_DATAGRAM; s++)
+	{
+		CRMScanHeader *scan = (CRMScanHeader *)(buf + len);
+		memset(scan, 0, sizeof(*scan));
+		scan->type = 1;
+		scan->length = sizeof(CRMScanHeader);
+		scan->azimuth = (azimuth + s) % SIM_SPOKES;
+		if (opt.hd)
+		{
+			scan->something_2 = 3;
+			scan->something_3 = 2;
+			scan->something_4 = 3;
+		}
+		else
+		{
+			scan->something_2 = 1;
+			scan->something_3 = 2;
+			scan->something_4 = 1;
+			scan->something_5 = 1;
+			scan->something_6 = 0x1f4;
+		}
+		scan->something_7 = 1;
+		len += sizeof(CRMScanHeader);
+
+		CRMOptHeader *opt_header = (CRMOptHeader *)(buf + len);
+		memset(opt_header, 0, sizeof(*opt_header));
+		opt_header->type = 2;
+		opt_header->length = sizeof(CRMOptHeader);
+		len += sizeof(CRMOptHeader);
+
+		data = (CRMScanData *)(buf + len);
+		uint8_t *payload = buf + len + sizeof(CRMScanData);
+		uint8_t returns[SIM_HD_RETURNS];
+		size_t data_len;
+
+		if (opt.hd)
+		{
+			GenerateSpoke(scan->azimuth, rotation, payload, SIM_HD_RETURNS);
+			data_len = SIM_HD_RETURNS;
+		}
+		else
+		{
+			GenerateSpoke(scan->azimuth, rotation, returns, SIM_RETURNS);
+			data_len = EncodeRegular(returns, payload);
+		}
+		data->type = 3;
+		data->data_len = data_len;
+		data->length = (sizeof(CRMScanData) + data_len + 3) & ~3;
+		memset(payload + data_len, 0, data->length - sizeof(CRMScanData) - data_len);
+		len += data->length;
+	}
+	data->type |= 0x80000000;  // Last spoke
+	header->nspokes = s;
+	*spokes = s;
+	return len;
+}
+
+static void Usage(const char *name)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -i address   interface address to use (default: first multicast capable one)\n"
+		"  -g group     multicast group for radar data (default %s)\n"
+		"  -p port      data port (default %d)\n"
+		"  -c port      command port (default %d)\n"
+		"  -r rate      spokes per second (default 819, 24 RPM)\n"
+		"  -s spokes    max spokes per packet (default 8), limited to what fits in %d bytes\n"
+		"  -l percent   scan packets to drop\n"
+		"  -j millis    max random delay added to each scan packet\n"
+		"  -H           send HD scan data\n"
+		"  -t           start transmitting without waiting for a command\n"
+		"  -d seconds   stop after this time\n"
+		"  -v           more output, repeat for more\n",
+		name, SIM_DATA_GROUP, SIM_DATA_PORT, SIM_COMMAND_PORT, SIM_MAX_DATAGRAM);
+}
+
+static bool ParseOptions(int argc, char **argv)
+{
+	int c;
+	bool have_interface = false;
+
+	memset(&opt, 0, sizeof(opt));
+	inet_aton(SIM_DATA_GROUP, &opt.data_group);
+	opt.data_port = SIM_DATA_PORT;
+	opt.command_port = SIM_COMMAND_PORT;
+	opt.spoke_rate = SIM_SPOKES * 24 / 60.;
+
+	while ((c = getopt(argc, argv, "i:g:p:c:r:s:l:j:Htd:v")) != -1)
+	{
+		switch (c)
+		{
+		case 'i':
+			if (!inet_aton(optarg, &opt.interface))
+			{
+				fprintf(stderr, "Invalid interface address %s\n", optarg);
+				return false;
+			}
+			have_interface = true;
+			break;
+		case 'g':
+			if (!inet_aton(optarg, &opt.data_group) || !IN_MULTICAST(ntohl(opt.data_group.s_addr)))
+			{
+				fprintf(stderr, "Invalid multicast group %s\n", optarg);
+				return false;
+			}
+			break;
+		case 'p':
+			opt.data_port = atoi(optarg);
+			break;
+		case 'c':
+			opt.command_port = atoi(optarg);
+			break;
+		case 'r':
+			opt.spoke_rate = atof(optarg);
+			break;
+		case 's':
+			opt.spokes_per_packet = atoi(optarg);
+			break;
+		case 'l':
+			opt.loss = atof(optarg) / 100.;
+			break;
+		case 'j':
+			opt.jitter = atof(optarg) / 1000.;
+			break;
+		case 'H':
+			opt.hd = true;
+			break;
+		case 't':
+			opt.transmit = true;
+			break;
+		case 'd':
+			opt.duration = atoi(optarg);
+			break;
+		case 'v':
+			opt.verbose++;
+			break;
+		default:
+			return false;
+		}
+	}
+
+	if (!have_interface && !FindInterface(&opt.interface))
+	{
+		fprintf(stderr, "No multicast capable interface found, use -i\n");
+		return false;
+	}
+	if (opt.spoke_rate <= 0.)
+	{
+		fprintf(stderr, "Spoke rate must be positive\n");
+		return false;
+	}
+	if (opt.spokes_per_packet <= 0)
+	{
+		opt.spokes_per_packet = 8;
+	}
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	if (!ParseOptions(argc, argv))
+	{
+		Usage(argv[0]);
+		return 1;
+	}
+
+	signal(SIGINT, OnSignal);
+	signal(SIGTERM, OnSignal);
+
+	memset(&state, 0, sizeof(state));
+	state.status = opt.transmit ? 1 : 0;
+	state.range_id = 4;
+	state.gain = 50;
+	state.auto_gain = 1;
+	state.sea = 30;
+	state.rain = 20;
+	state.ftc = 20;
+	state.tune = 50;
+	state.auto_tune = 1;
+	state.interference_rejection = 1;
+	state.display_timing = 0x6d;
+	state.stc_preset = 0x74;
+	state.curve = 1;
+
+	tx_socket = OpenSender();
+	command_socket = OpenReceiver(opt.command_port, 0);
+	wakeup_socket = OpenReceiver(SEATALK_HS_ANNOUNCE_PORT, SEATALK_HS_ANNOUNCE_GROUP);
+	if (tx_socket < 0 || command_socket < 0 || wakeup_socket < 0)
+	{
+		return 1;
+	}
+
+	char data_group[INET_ADDRSTRLEN], interface[INET_ADDRSTRLEN];
+	inet_ntop(AF_INET, &opt.data_group, data_group, sizeof(data_group));
+	inet_ntop(AF_INET, &opt.interface, interface, sizeof(interface));
+	fprintf(stderr, "Simulating %s radar on %s: data %s:%d, commands on port %d, %.0f spokes/s, %d spokes/packet\n",
+		opt.hd ? "HD" : "regular", interface, data_group, opt.data_port, opt.command_port, opt.spoke_rate,
+		opt.spokes_per_packet);
+
+	double start = Now();
+	double next_ideal = start;   // Jitter free schedule of the scan packets
+	double next_packet = start;  // Actual send time, never earlier than the previous one
+	double next_second = start;
+	int azimuth = 0;
+	int rotation = 0;
+	uint32_t spoke_count = 0;
+	uint8_t packet[SIM_MAX_DATAGRAM];
+
+	while (!quit)
+	{
+		double now = Now();
+
+		if (opt.duration && now - start >= opt.duration)
+		{
+			break;
+		}
+
+		if (now >= next_second)
+		{
+			next_second += 1.;
+			if (state.status == 2 && --state.warmup_left <= 0)
+			{
+				state.status = 0;
+			}
+			SendAnnounce();
+			SendFeedback();
+			SendPresetFeedback();
+			if (opt.verbose)
+			{
+				fprintf(stderr, "status %d: %ld packets (%ld dropped), %ld spokes, %ld bytes, %ld commands\n", state.status,
+					stats.packets, stats.dropped, stats.spokes, stats.bytes, stats.commands);
+			}
+		}
+
+		while (now >= next_packet)
+		{
+			int spokes = opt.spokes_per_packet;
+			if (state.status == 1)
+			{
+				size_t len = BuildScanPacket(packet, azimuth, rotation, spoke_count, &spokes);
+				if (Random() < opt.loss)
+				{
+					stats.dropped++;
+				}
+				else
+				{
+					SendData(packet, len);
+					stats.packets++;
+					stats.bytes += len;
+				}
+				stats.spokes += spokes;
+				spoke_count += spokes;
+				azimuth += spokes;
+				if (azimuth >= SIM_SPOKES)
+				{
+					azimuth -= SIM_SPOKES;
+					rotation++;
+				}
+			}
+			next_ideal += spokes / opt.spoke_rate;
+			double jittered = next_ideal + opt.jitter * Random();
+			next_packet = jittered > next_packet ? jittered : next_packet;
+			if (now - next_ideal > 1.)
+			{
+				// Hopelessly behind (suspended?), don't try to catch up
+				next_ideal = next_packet = now;
+			}
+		}
+
+		double wait = (next_packet < next_second ? next_packet : next_second) - Now();
+		struct pollfd fds[2];
+		fds[0].fd = command_socket;
+		fds[0].events = POLLIN;
+		fds[1].fd = wakeup_socket;
+		fds[1].events = POLLIN;
+		int r = poll(fds, 2, wait > 0. ? (int)(wait * 1000.) : 0);
+		if (r < 0 && errno != EINTR)
+		{
+			perror("poll");
+			break;
+		}
+		uint8_t msg[SIM_MAX_DATAGRAM];
+		if (r > 0 && (fds[0].revents & POLLIN))
+		{
+			int len = recv(command_socket, msg, sizeof(msg), 0);
+			if (len > 0)
+			{
+				HandleCommand(msg, len);
+			}
+		}
+		if (r > 0 && (fds[1].revents & POLLIN))
+		{
+			int len = recv(wakeup_socket, msg, sizeof(msg), 0);
+			if (len == sizeof(sim_wakeup_msg) - 1 && !memcmp(msg, sim_wakeup_msg, len) && state.status == 3)
+			{
+				state.status = 2;
+				state.warmup_left = SIM_WARMUP_SECONDS;
+				SendFeedback();
+			}
+		}
+	}
+
+	fprintf(stderr, "%ld packets (%ld dropped), %ld spokes, %ld bytes, %ld commands\n", stats.packets, stats.dropped,
+		stats.spokes, stats.bytes, stats.commands);
+	close(tx_socket);
+	close(command_socket);
+	close(wakeup_socket);
+	return 0;
+}